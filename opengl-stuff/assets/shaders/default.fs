@@ -5,11 +5,17 @@ in vec2 TexCoord;
 in vec3 Normal;
 in vec3 FragPos;
 
-struct Light {
-    vec3 position;
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+// Camera and light of the frame, filled once per frame by the renderer (std140, see Renderer::FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 viewPos;
+    vec4 lightPosition;
+    vec4 lightAmbient;
+    vec4 lightDiffuse;
+    vec4 lightSpecular;
 };
 
 struct Material {
@@ -22,26 +28,24 @@ struct Material {
 };
 
 uniform sampler2D texBuff;
-uniform vec3 viewPos;
-uniform Light light;
 uniform Material material;
 
 void main() {
 
 	// ambient
-    vec3 ambient = light.ambient * material.ambient;
+    vec3 ambient = lightAmbient.xyz * material.ambient;
   	
     // diffuse 
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(light.position - FragPos);
+    vec3 lightDir = normalize(lightPosition.xyz - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * (diff * material.diffuse);
+    vec3 diffuse = lightDiffuse.xyz * (diff * material.diffuse);
     
     // specular
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     vec3 reflectDir = reflect(-lightDir, norm);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
-    vec3 specular = light.specular * (spec * material.specular);
+    vec3 specular = lightSpecular.xyz * (spec * material.specular);
 
     // emissive
     // not fully implemented yet
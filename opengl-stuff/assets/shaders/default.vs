@@ -2,19 +2,51 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
 layout (location = 2) in vec3 aNormal;
+// Model matrix of the instance, locations 3 to 6 (see GeometryArena::INSTANCE_MODEL_ATTRIBUTE)
+layout (location = 3) in mat4 model;
+// Inverse transpose of mat3(model), computed once per object on the CPU (locations 7 to 9)
+layout (location = 7) in mat3 normalMatrix;
 
 out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragPos;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Camera and light of the frame, filled once per frame by the renderer (std140, see Renderer::FrameUniforms)
+layout (std140) uniform FrameUniforms
+{
+	mat4 view;
+	mat4 projection;
+	mat4 viewProjection;
+	vec4 viewPos;
+	vec4 lightPosition;
+	vec4 lightAmbient;
+	vec4 lightDiffuse;
+	vec4 lightSpecular;
+};
+
+// Compressed vertex format: positions are quantized inside the mesh bounds and normals are
+// octahedral-encoded bytes. The float format uses scale 1, offset 0 and plain normals.
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0f);
+	vec3 position = aPos * positionScale + positionOffset;
+	vec4 worldPosition = model * vec4(position, 1.0);
+	gl_Position = viewProjection * worldPosition;
 	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
-	Normal = aNormal;
-	FragPos = vec3(model * vec4(aPos, 1.0));
-}
\ No newline at end of file
+	vec3 normal = octahedralNormals ? decodeOctahedral(aNormal.xy / 127.0) : aNormal;
+	// Lighting is done in world space, the normal matrix keeps normals right under non-uniform scale
+	Normal = normalMatrix * normal;
+	FragPos = vec3(worldPosition);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Microbenchmarks for the import pipeline, run from the opengl-stuff directory so the
+// default asset paths resolve. Each benchmark is a subcommand of opengl-stuff-bench.
+namespace bench {
+    typedef std::chrono::steady_clock Clock;
+
+    inline double elapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Runs func the given number of times and returns the fastest run in milliseconds
+    template <typename Func>
+    double bestOf(int repeats, Func func) {
+        double best = 0.0;
+        for (int i = 0; i < repeats; ++i) {
+            Clock::time_point start = Clock::now();
+            func();
+            double ms = elapsedMs(start);
+            if (i == 0 || ms < best) {
+                best = ms;
+            }
+        }
+        return best;
+    }
+
+    // The paths given on the command line, or every file with the extension under the directory
+    inline std::vector<std::string> collectFiles(const std::vector<std::string>& paths, const std::string& directory, const std::string& extension) {
+        if (!paths.empty()) {
+            return paths;
+        }
+        std::vector<std::string> files;
+        if (!fs::exists(directory)) {
+            return files;
+        }
+        for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory)) {
+            if (entry.is_regular_file() && entry.path().extension() == extension) {
+                files.push_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        return files;
+    }
+
+    int runConversion(const std::vector<std::string>& args);
+    int runObj(const std::vector<std::string>& args);
+    int runImport(const std::vector<std::string>& args);
+}
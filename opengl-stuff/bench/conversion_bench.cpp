@@ -0,0 +1,124 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "bench.h"
+#include "object_reader.hpp"
+
+// Conversion as ObjectReader did it before the bulk copy: push_back per vertex into vectors that
+// were never reserved, branching on the attribute layout inside the loop. Kept as the reference.
+static MeshData convertMeshLegacy(const aiMesh* mesh) {
+    MeshData data;
+    data.name = mesh->mName.C_Str();
+    data.materialIndex = mesh->mMaterialIndex;
+
+    for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
+        glm::vec3 auxVertex;
+        auxVertex.x = mesh->mVertices[i].x;
+        auxVertex.y = mesh->mVertices[i].y;
+        auxVertex.z = mesh->mVertices[i].z;
+        data.vertices.push_back(auxVertex);
+
+        if (mesh->HasTextureCoords(0)) {
+            glm::vec2 texCoord;
+            texCoord.x = mesh->mTextureCoords[0][i].x;
+            texCoord.y = mesh->mTextureCoords[0][i].y;
+            data.texCoords.push_back(texCoord);
+        }
+
+        if (mesh->HasNormals()) {
+            glm::vec3 normal;
+            normal.x = mesh->mNormals[i].x;
+            normal.y = mesh->mNormals[i].y;
+            normal.z = mesh->mNormals[i].z;
+            data.normals.push_back(normal);
+        } else {
+            data.normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+    }
+
+    for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+        const aiFace& face = mesh->mFaces[i];
+        for (unsigned int j = 0; j < face.mNumIndices; ++j) {
+            data.indices.push_back(face.mIndices[j]);
+        }
+    }
+
+    return data;
+}
+
+static bool sameMesh(const MeshData& a, const MeshData& b) {
+    return a.name == b.name && a.materialIndex == b.materialIndex
+        && a.vertices == b.vertices && a.texCoords == b.texCoords
+        && a.normals == b.normals && a.indices == b.indices;
+}
+
+template <typename Convert>
+static void convertAll(const aiScene* scene, Convert convert, std::vector<MeshData>& out) {
+    out.clear();
+    for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
+        out.push_back(convert(scene->mMeshes[i]));
+    }
+}
+
+// usage: conversion [--repeat N] [model files...], defaults to every .obj under assets/obj
+int bench::runConversion(const std::vector<std::string>& args) {
+    int repeats = 5;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--repeat" && i + 1 < args.size()) {
+            repeats = std::max(1, std::atoi(args[++i].c_str()));
+        } else {
+            paths.push_back(args[i]);
+        }
+    }
+
+    std::vector<std::string> files = collectFiles(paths, "assets/obj", ".obj");
+    if (files.empty()) {
+        std::cerr << "No models to convert, run from the opengl-stuff directory or pass model paths" << std::endl;
+        return 1;
+    }
+
+    std::printf("%-48s %10s %10s %12s %12s %8s\n", "model", "vertices", "indices", "legacy ms", "bulk ms", "speedup");
+    double legacyTotal = 0.0, bulkTotal = 0.0;
+    bool allEqual = true;
+    for (const std::string& file : files) {
+        Assimp::Importer importer;
+        const aiScene* scene = importer.ReadFile(file, IMPORT_BASE_FLAGS);
+        if (!scene || !scene->mRootNode) {
+            std::cerr << "Failed to read " << file << ": " << importer.GetErrorString() << std::endl;
+            continue;
+        }
+
+        size_t vertexCount = 0, indexCount = 0;
+        std::vector<MeshData> legacy, bulk;
+        double legacyMs = bestOf(repeats, [&]() { convertAll(scene, convertMeshLegacy, legacy); });
+        double bulkMs = bestOf(repeats, [&]() { convertAll(scene, ObjectReader::convertMesh, bulk); });
+        for (size_t i = 0; i < bulk.size(); ++i) {
+            vertexCount += bulk[i].vertices.size();
+            indexCount += bulk[i].indices.size();
+            if (!sameMesh(legacy[i], bulk[i])) {
+                std::cerr << "Mismatch in " << file << ", mesh " << i << std::endl;
+                allEqual = false;
+            }
+        }
+
+        std::printf("%-48s %10zu %10zu %12.3f %12.3f %7.2fx\n", file.c_str(), vertexCount, indexCount, legacyMs, bulkMs, legacyMs / std::max(bulkMs, 1e-6));
+        legacyTotal += legacyMs;
+        bulkTotal += bulkMs;
+    }
+    std::printf("%-48s %10s %10s %12.3f %12.3f %7.2fx\n", "total", "", "", legacyTotal, bulkTotal, legacyTotal / std::max(bulkTotal, 1e-6));
+
+    return allEqual ? 0 : 1;
+}
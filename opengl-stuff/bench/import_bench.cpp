@@ -0,0 +1,352 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "bench.h"
+#include "geometry_arena.h"
+#include "geometry_registry.h"
+#include "gpu_memory.h"
+#include "mesh_cache.h"
+#include "object_reader.hpp"
+#include "resource_manager.h"
+#include "scene.hpp"
+
+namespace {
+
+struct ImportResult {
+    std::string file;
+    bool scene = false;
+    bool ok = false;
+    double totalMs = 0.0;
+    ImportStats stats;
+    double peakMemoryMB = 0.0;
+    double vertexMemoryMB = 0.0;  // vertex buffers of the imported geometry, GL mode only
+    // GL memory held once the file is loaded, GL mode only
+    size_t gpuCategoryBytes[GpuMemoryCategory_Count] = {};
+    std::vector<GpuResource> gpuLargest;
+};
+
+// Number of resources listed per file under "gpuLargest"
+const size_t GPU_LARGEST_COUNT = 5;
+
+double getVertexMemoryMB() {
+    return GeometryRegistry::getVertexMemory() / (1024.0 * 1024.0);
+}
+
+void captureGpuMemory(ImportResult& result) {
+    for (int category = 0; category < GpuMemoryCategory_Count; ++category) {
+        result.gpuCategoryBytes[category] = GpuMemory::getCategoryBytes(category);
+    }
+    result.gpuLargest = GpuMemory::getLargestResources(GPU_LARGEST_COUNT);
+}
+
+// Peak resident memory of the process so far
+double getPeakMemoryMB() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+    }
+    return 0.0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+// Hidden window whose context receives the uploads, nothing is ever shown
+GLFWwindow* createHiddenContext() {
+    if (!glfwInit()) {
+        return nullptr;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "opengl-stuff-bench", NULL, NULL);
+    if (!window) {
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    return window;
+}
+
+// Models referenced by a scene file, with their profiles, for runs without a GL context
+bool readSceneModels(const std::string& file, std::vector<std::pair<std::string, ImportProfile>>& models) {
+    std::ifstream in(file);
+    std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    rapidjson::Document doc;
+    doc.Parse(json.c_str());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("scene") || !doc["scene"].IsObject()
+        || !doc["scene"].HasMember("objects") || !doc["scene"]["objects"].IsArray()) {
+        return false;
+    }
+    for (auto& o : doc["scene"]["objects"].GetArray()) {
+        // Same checks as Scene::parse
+        if (!o.IsObject() || !o.HasMember("path") || !o["path"].IsString()) {
+            std::cerr << "Error parsing object from JSON: \"path\" member not found or not a string" << std::endl;
+            continue;
+        }
+        ImportProfile profile = ImportProfile_Fast;
+        if (o.HasMember("profile")) {
+            if (!o["profile"].IsString()) {
+                std::cerr << "Error parsing object from JSON: profile is not a string, using \"fast\"" << std::endl;
+            } else if (!parseImportProfile(o["profile"].GetString(), profile)) {
+                std::cerr << "Error parsing object from JSON: unknown profile \"" << o["profile"].GetString() << "\", using \"fast\"" << std::endl;
+            }
+        }
+        models.push_back({ o["path"].GetString(), profile });
+    }
+    return true;
+}
+
+ImportResult importModel(const std::string& file, ImportProfile profile, bool gl) {
+    ImportResult result;
+    result.file = file;
+    ObjectReader reader;
+    bench::Clock::time_point start = bench::Clock::now();
+    if (gl) {
+        std::vector<Object3D*> objects = reader.readModel(file.c_str(), profile);
+        // Make the upload time include the work the driver deferred
+        bench::Clock::time_point finishStart = bench::Clock::now();
+        glFinish();
+        result.totalMs = bench::elapsedMs(start);
+        result.ok = !objects.empty();
+        result.stats = reader.getLastStats();
+        result.stats.uploadMs += bench::elapsedMs(finishStart);
+        result.vertexMemoryMB = getVertexMemoryMB();
+        captureGpuMemory(result);
+        for (Object3D* object : objects) {
+            delete object;
+        }
+    } else {
+        ModelData model;
+        result.ok = reader.loadModelData(file.c_str(), model, profile);
+        result.totalMs = bench::elapsedMs(start);
+        result.stats = reader.getLastStats();
+    }
+    return result;
+}
+
+ImportResult importScene(const std::string& file, bool gl) {
+    ImportResult result;
+    result.file = file;
+    result.scene = true;
+    bench::Clock::time_point start = bench::Clock::now();
+    if (gl) {
+        Scene scene;
+        scene.parse(file.c_str());
+        bench::Clock::time_point finishStart = bench::Clock::now();
+        glFinish();
+        result.totalMs = bench::elapsedMs(start);
+        result.ok = !scene.objects.empty();
+        result.stats = scene.importStats;
+        result.stats.uploadMs += bench::elapsedMs(finishStart);
+        result.vertexMemoryMB = getVertexMemoryMB();
+        captureGpuMemory(result);
+        for (Object3D* object : scene.objects) {
+            delete object;
+        }
+    } else {
+        std::vector<std::pair<std::string, ImportProfile>> models;
+        result.ok = readSceneModels(file, models);
+        for (const auto& model : models) {
+            ImportResult modelResult = importModel(model.first, model.second, false);
+            result.ok = result.ok && modelResult.ok;
+            result.stats.add(modelResult.stats);
+        }
+        result.totalMs = bench::elapsedMs(start);
+    }
+    return result;
+}
+
+void writeResult(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, const ImportResult& result) {
+    writer.StartObject();
+    writer.Key("file"); writer.String(result.file.c_str());
+    writer.Key("type"); writer.String(result.scene ? "scene" : "model");
+    writer.Key("ok"); writer.Bool(result.ok);
+    if (!result.scene) {
+        writer.Key("cache"); writer.Bool(result.stats.fromCache);
+        writer.Key("nativeParser"); writer.Bool(result.stats.nativeParser);
+    }
+    writer.Key("totalMs"); writer.Double(result.totalMs);
+    writer.Key("cacheMs"); writer.Double(result.stats.cacheMs);
+    writer.Key("parseMs"); writer.Double(result.stats.parseMs);
+    writer.Key("convertMs"); writer.Double(result.stats.convertMs);
+    writer.Key("texturesMs"); writer.Double(result.stats.texturesMs);
+    writer.Key("uploadMs"); writer.Double(result.stats.uploadMs);
+    writer.Key("meshes"); writer.Uint64(result.stats.meshes);
+    writer.Key("vertices"); writer.Uint64(result.stats.vertices);
+    writer.Key("indices"); writer.Uint64(result.stats.indices);
+    if (result.stats.cacheAfter.triangles > 0) {
+        writer.Key("acmrBefore"); writer.Double(result.stats.cacheBefore.getACMR());
+        writer.Key("acmrAfter"); writer.Double(result.stats.cacheAfter.getACMR());
+        writer.Key("atvrBefore"); writer.Double(result.stats.cacheBefore.getATVR());
+        writer.Key("atvrAfter"); writer.Double(result.stats.cacheAfter.getATVR());
+    }
+    if (result.stats.meshlets > 0) {
+        writer.Key("meshlets"); writer.Uint64(result.stats.meshlets);
+    }
+    writer.Key("vertexMemoryMB"); writer.Double(result.vertexMemoryMB);
+    if (!result.gpuLargest.empty()) {
+        writer.Key("gpuMemoryMB");
+        writer.StartObject();
+        for (int category = 0; category < GpuMemoryCategory_Count; ++category) {
+            writer.Key(GPU_MEMORY_CATEGORY_NAMES[category]); writer.Double(result.gpuCategoryBytes[category] / (1024.0 * 1024.0));
+        }
+        writer.EndObject();
+        writer.Key("gpuLargest");
+        writer.StartArray();
+        for (const GpuResource& resource : result.gpuLargest) {
+            writer.StartObject();
+            writer.Key("name"); writer.String(resource.name.c_str());
+            writer.Key("category"); writer.String(GPU_MEMORY_CATEGORY_NAMES[resource.category]);
+            writer.Key("format"); writer.String(resource.format.c_str());
+            writer.Key("MB"); writer.Double(resource.bytes / (1024.0 * 1024.0));
+            writer.EndObject();
+        }
+        writer.EndArray();
+    }
+    writer.Key("peakMemoryMB"); writer.Double(result.peakMemoryMB);
+    writer.EndObject();
+}
+
+}
+
+// usage: import [--no-gl] [--no-cache] [--profile name] [--vertex-format name] [--output file] [models or scene .json files...]
+// defaults to every .obj under assets/obj and every scene under assets/scenes
+int bench::runImport(const std::vector<std::string>& args) {
+    bool gl = true;
+    bool cache = true;
+    ImportProfile profile = ImportProfile_Fast;
+    VertexFormat vertexFormat = GeometryRegistry::getVertexFormat();
+    std::string outputPath;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--no-gl") {
+            gl = false;
+        } else if (args[i] == "--no-cache") {
+            cache = false;
+        } else if (args[i] == "--profile" && i + 1 < args.size()) {
+            if (!parseImportProfile(args[++i], profile)) {
+                std::cerr << "Unknown profile: " << args[i] << std::endl;
+                return 1;
+            }
+        } else if (args[i] == "--vertex-format" && i + 1 < args.size()) {
+            if (!parseVertexFormat(args[++i], vertexFormat)) {
+                std::cerr << "Unknown vertex format: " << args[i] << std::endl;
+                return 1;
+            }
+        } else if (args[i] == "--output" && i + 1 < args.size()) {
+            outputPath = args[++i];
+        } else {
+            paths.push_back(args[i]);
+        }
+    }
+
+    std::vector<std::string> files = paths;
+    if (files.empty()) {
+        files = collectFiles(paths, "assets/obj", ".obj");
+        std::vector<std::string> scenes = collectFiles(paths, "assets/scenes", ".json");
+        files.insert(files.end(), scenes.begin(), scenes.end());
+    }
+    if (files.empty()) {
+        std::cerr << "Nothing to import, run from the opengl-stuff directory or pass file paths" << std::endl;
+        return 1;
+    }
+
+    GLFWwindow* window = nullptr;
+    if (gl) {
+        window = createHiddenContext();
+        if (!window) {
+            std::cerr << "Failed to create a hidden GL context, use --no-gl to skip the upload" << std::endl;
+            return 1;
+        }
+    }
+    MeshCache::setEnabled(cache);
+    GeometryRegistry::setVertexFormat(vertexFormat);
+
+    // The importer logs to std::cout, which is kept for the JSON report
+    std::streambuf* coutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+    std::vector<ImportResult> results;
+    bool allOk = true;
+    for (const std::string& file : files) {
+        bool scene = fs::path(file).extension() == ".json";
+        ImportResult result = scene ? importScene(file, gl) : importModel(file, profile, gl);
+        result.peakMemoryMB = getPeakMemoryMB();
+        allOk = allOk && result.ok;
+        results.push_back(result);
+        // Every file starts without the textures and geometry buffers of the previous one
+        if (gl) {
+            ResourceManager::clear();
+            GeometryArena::compact();
+        }
+    }
+    std::cout.rdbuf(coutBuffer);
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("mode"); writer.String(gl ? "gl" : "no-gl");
+    writer.Key("cache"); writer.Bool(cache);
+    writer.Key("profile"); writer.String(getImportProfileName(profile));
+    writer.Key("vertexFormat"); writer.String(getVertexFormatName(vertexFormat));
+    writer.Key("threads"); writer.Uint(ThreadPool::shared().getConcurrency());
+    writer.Key("results");
+    writer.StartArray();
+    for (const ImportResult& result : results) {
+        writeResult(writer, result);
+    }
+    writer.EndArray();
+    if (gl) {
+        writer.Key("gpuPeakMemoryMB"); writer.Double(GpuMemory::getPeakBytes() / (1024.0 * 1024.0));
+    }
+    writer.Key("peakMemoryMB"); writer.Double(getPeakMemoryMB());
+    writer.EndObject();
+
+    if (outputPath.empty()) {
+        std::cout << buffer.GetString() << std::endl;
+    } else {
+        std::ofstream out(outputPath);
+        out << buffer.GetString() << std::endl;
+    }
+
+    if (window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    return allOk ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+
+struct BenchCommand {
+    const char* name;
+    const char* description;
+    int (*run)(const std::vector<std::string>& args);
+};
+
+static const BenchCommand COMMANDS[] = {
+    { "conversion", "aiMesh to MeshData conversion, legacy per-vertex path against the bulk copy", bench::runConversion },
+    { "obj", "Assimp against the native .obj reader, parse and conversion", bench::runObj },
+    { "import", "full import of models and scenes with stage timings and peak memory as JSON", bench::runImport },
+};
+
+static void printUsage() {
+    std::cout << "usage: opengl-stuff-bench <command> [args]" << std::endl;
+    for (const BenchCommand& command : COMMANDS) {
+        std::cout << "  " << command.name << " - " << command.description << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+    std::vector<std::string> args(argv + 2, argv + argc);
+    for (const BenchCommand& command : COMMANDS) {
+        if (std::strcmp(argv[1], command.name) == 0) {
+            return command.run(args);
+        }
+    }
+    std::cerr << "Unknown benchmark: " << argv[1] << std::endl;
+    printUsage();
+    return 1;
+}
@@ -0,0 +1,103 @@
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+#include "bench.h"
+#include "obj_file_reader.h"
+#include "object_reader.hpp"
+
+struct ObjResult {
+    size_t meshes = 0;
+    size_t vertices = 0;
+    size_t triangles = 0;
+};
+
+static ObjResult summarize(const std::vector<MeshData>& meshes) {
+    ObjResult result;
+    result.meshes = meshes.size();
+    for (const MeshData& mesh : meshes) {
+        result.vertices += mesh.vertices.size();
+        result.triangles += mesh.indices.size() / 3;
+    }
+    return result;
+}
+
+// What the fast profile did before the native reader: Assimp parse plus the mesh conversion
+static bool readWithAssimp(const std::string& file, ObjResult& result) {
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(file, IMPORT_BASE_FLAGS);
+    if (!scene || !scene->mRootNode) {
+        return false;
+    }
+    std::vector<MeshData> meshes(scene->mNumMeshes);
+    ThreadPool::shared().parallelFor(meshes.size(), [&](size_t i) {
+        meshes[i] = ObjectReader::convertMesh(scene->mMeshes[i]);
+    });
+    result = summarize(meshes);
+    return true;
+}
+
+static bool readNative(const std::string& file, ObjResult& result) {
+    ModelData model;
+    if (!ObjFileReader::read(file, model)) {
+        return false;
+    }
+    result = summarize(model.meshes);
+    return true;
+}
+
+// usage: obj [--repeat N] [.obj files...], defaults to every .obj under assets/obj
+int bench::runObj(const std::vector<std::string>& args) {
+    int repeats = 3;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--repeat" && i + 1 < args.size()) {
+            repeats = std::max(1, std::atoi(args[++i].c_str()));
+        } else {
+            paths.push_back(args[i]);
+        }
+    }
+
+    std::vector<std::string> files = collectFiles(paths, "assets/obj", ".obj");
+    if (files.empty()) {
+        std::cerr << "No .obj files found, run from the opengl-stuff directory or pass file paths" << std::endl;
+        return 1;
+    }
+
+    std::printf("%-48s %10s %10s %10s %10s %12s %12s %8s\n", "model", "triangles", "(assimp)", "vertices", "(assimp)", "assimp ms", "native ms", "speedup");
+    double assimpTotal = 0.0, nativeTotal = 0.0;
+    bool allEqual = true;
+    for (const std::string& file : files) {
+        ObjResult assimp, native;
+        bool assimpOk = true, nativeOk = true;
+        double assimpMs = bestOf(repeats, [&]() { assimpOk = readWithAssimp(file, assimp); });
+        double nativeMs = bestOf(repeats, [&]() { nativeOk = readNative(file, native); });
+        if (!assimpOk || !nativeOk) {
+            std::printf("%-48s %s\n", file.c_str(), !nativeOk ? "native reader failed, Assimp fallback" : "Assimp failed");
+            continue;
+        }
+        // Vertex counts differ on purpose, the native reader welds shared corners
+        if (native.triangles != assimp.triangles) {
+            allEqual = false;
+        }
+        std::printf("%-48s %10zu %10zu %10zu %10zu %12.3f %12.3f %7.2fx%s\n", file.c_str(),
+            native.triangles, assimp.triangles, native.vertices, assimp.vertices,
+            assimpMs, nativeMs, assimpMs / std::max(nativeMs, 1e-6), native.triangles != assimp.triangles ? "  triangle count differs" : "");
+        assimpTotal += assimpMs;
+        nativeTotal += nativeMs;
+    }
+    std::printf("%-48s %10s %10s %10s %10s %12.3f %12.3f %7.2fx\n", "total", "", "", "", "", assimpTotal, nativeTotal, assimpTotal / std::max(nativeTotal, 1e-6));
+
+    return allEqual ? 0 : 1;
+}
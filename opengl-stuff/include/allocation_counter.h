@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+// A static class counting the heap allocations made through the global operator new, by any
+// thread. Take the count before and after a piece of code to see how many allocations it made,
+// the difference includes what other threads allocated meanwhile.
+// Counting replaces the global operator new and delete of the program (see allocation_counter.cpp).
+class AllocationCounter
+{
+public:
+    // allocations made since the program started
+    static size_t getCount();
+private:
+    // private constructor, all functions are static
+    AllocationCounter() { }
+};
@@ -66,6 +66,19 @@ public:
     	meshGroup.update();
 	}
 
+	/**
+	 * Stops animating an object, which must be done before it is deleted.
+	 * @param transformable The object to remove from the mesh group.
+	*/
+	void remove(const Transformable* transformable) {
+		meshGroup.remove(transformable);
+	}
+
+	// Whether no object is left to animate
+	bool empty() {
+		return meshGroup.empty();
+	}
+
 private:
 	TransformableGroup meshGroup;
 	int frameCounter;
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "import_profile.hpp"
+#include "mesh_data.hpp"
+#include "object_3d.hpp"
+#include "object_reader.hpp"
+
+// Imports a model on a background thread.
+// The worker parses and converts the model while the GL thread calls poll() once per frame to
+// upload the meshes that are ready, within a time budget. The scene keeps rendering during the
+// import and objects show up as soon as their mesh is converted.
+class AsyncImporter : private ImportListener {
+public:
+    AsyncImporter() : running(false), cancelled(false), failed(false), progress(0.0f), materialsCreated(false), materialsReady(false) { }
+
+    ~AsyncImporter() {
+        cancel();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    /**
+     * Starts importing a model in the background.
+     *
+     * @param filePath The path to the model file.
+     * @param profile The post-processing applied by Assimp, see ImportProfile.
+     * @return false if another import is still running.
+     */
+    bool start(const std::string& filePath, ImportProfile profile = ImportProfile_Fast) {
+        if (isBusy()) {
+            return false;
+        }
+        if (worker.joinable()) {
+            worker.join();
+        }
+        this->filePath = filePath;
+        this->model = ModelData();
+        this->pending.clear();
+        this->materialsReady = false;
+        this->materials.clear();
+        this->materialsCreated = false;
+        this->progress = 0.0f;
+        this->cancelled = false;
+        this->failed = false;
+        this->running = true;
+        worker = std::thread([this, profile]() {
+            ObjectReader reader;
+            ModelData data;
+            bool loaded = false;
+            try {
+                loaded = reader.loadModelData(this->filePath.c_str(), data, profile, this);
+            } catch (const std::exception& e) {
+                std::cerr << "AsyncImporter: " << this->filePath << ": " << e.what() << std::endl;
+            }
+            failed = !loaded && !cancelled;
+            running = false;
+        });
+        return true;
+    }
+
+    // Stops the running import, meshes not uploaded yet are discarded
+    void cancel() {
+        cancelled = true;
+    }
+
+    bool isCancelled() override {
+        return cancelled;
+    }
+
+    // Whether an import is running or still has meshes waiting for upload
+    bool isBusy() {
+        if (running) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        return !cancelled && !pending.empty();
+    }
+
+    float getProgress() {
+        return progress;
+    }
+
+    // Whether the last import could not read the model, kept until the next start()
+    bool hasFailed() {
+        return failed;
+    }
+
+    const std::string& getFilePath() {
+        return filePath;
+    }
+
+    /**
+     * Uploads the meshes converted so far. Must be called from the thread that owns the GL context.
+     *
+     * @param budgetMs Time after which no further mesh is uploaded in this call.
+     * @return The objects created in this call.
+     */
+    std::vector<Object3D*> poll(double budgetMs) {
+        std::vector<Object3D*> objects;
+        auto start = std::chrono::steady_clock::now();
+        while (!cancelled) {
+            MeshData meshData;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!materialsReady || pending.empty()) {
+                    break;
+                }
+                meshData = std::move(pending.front());
+                pending.pop_front();
+            }
+            // model is read-only once materialsReady is set, so the materials are created outside the lock
+            if (!materialsCreated) {
+                materials = uploader.createMaterials(model, filePath);
+                materialsCreated = true;
+            }
+            objects.push_back(uploader.createObject(meshData, materials));
+            if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() >= budgetMs) {
+                break;
+            }
+        }
+        if (!running && worker.joinable()) {
+            worker.join();
+            if (cancelled) {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.clear();
+            }
+        }
+        return objects;
+    }
+
+private:
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<bool> cancelled;
+    std::atomic<bool> failed;
+    std::atomic<float> progress;
+    std::string filePath;
+    // used on the GL thread only, to turn converted meshes into objects
+    ObjectReader uploader;
+    // materials with their textures, created on the GL thread with the first mesh and shared by all meshes
+    ObjectReader::MaterialList materials;
+    bool materialsCreated;
+
+    // guards pending, model and materialsReady, which the worker fills
+    std::mutex mutex;
+    std::deque<MeshData> pending;
+    // materials and decoded images of the model being imported, read-only once materialsReady is set
+    ModelData model;
+    bool materialsReady;
+
+    void onProgress(float progress) override {
+        this->progress = progress;
+    }
+
+    void onMaterials(const ModelData& model) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->model.materials = model.materials;
+        this->model.images = model.images;
+        this->materialsReady = true;
+    }
+
+    void onMeshReady(MeshData&& mesh) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(mesh));
+    }
+};
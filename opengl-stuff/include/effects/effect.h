@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 
 #include "framebuffer.hpp"
+#include "gl_state.h"
 
 class Effect {
 public:
@@ -21,7 +22,7 @@ public:
         unsigned int quadVBO;
         glGenVertexArrays(1, &this->quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(this->quadVAO);
+        GLState::bindVertexArray(this->quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -29,7 +30,7 @@ public:
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        GLState::bindVertexArray(0);
 	}
 
 	void apply(FrameBuffer& inputFramebuffer, FrameBuffer& outputFramebuffer) {
@@ -37,8 +38,8 @@ public:
         setup();
         // Render texture with effect in the output framebuffer
         outputFramebuffer.bind();
-        glBindVertexArray(quadVAO);
-        glActiveTexture(GL_TEXTURE0);
+        GLState::bindVertexArray(quadVAO);
+        GLState::activeTexture(0);
         inputFramebuffer.texture.bind();
         glDrawArrays(GL_TRIANGLES, 0, 6);
 	}
@@ -3,9 +3,15 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <string>
+#include <utility>
 
+#include "gl_state.h"
+#include "gpu_memory.h"
 #include "texture.h"
 
+// A framebuffer with a color texture and a depth/stencil renderbuffer. It owns its GL objects: it
+// can be moved but not copied, and deletes them when destroyed. Id 0 is the default framebuffer.
 class FrameBuffer {
 public:
     GLuint id;
@@ -13,7 +19,37 @@ public:
     int width;
     int height;
 
-    FrameBuffer() : id(0), width(0), height(0) { }
+    FrameBuffer() : id(0), width(0), height(0), renderBuffer(0), renderBufferMemoryId(GpuMemory::NONE) { }
+
+    ~FrameBuffer() {
+        release();
+    }
+
+    FrameBuffer(const FrameBuffer&) = delete;
+    FrameBuffer& operator=(const FrameBuffer&) = delete;
+
+    FrameBuffer(FrameBuffer&& other) noexcept : id(other.id), texture(std::move(other.texture)), width(other.width), height(other.height),
+        renderBuffer(other.renderBuffer), renderBufferMemoryId(other.renderBufferMemoryId) {
+        other.id = 0;
+        other.renderBuffer = 0;
+        other.renderBufferMemoryId = GpuMemory::NONE;
+    }
+
+    FrameBuffer& operator=(FrameBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            id = other.id;
+            texture = std::move(other.texture);
+            width = other.width;
+            height = other.height;
+            renderBuffer = other.renderBuffer;
+            renderBufferMemoryId = other.renderBufferMemoryId;
+            other.id = 0;
+            other.renderBuffer = 0;
+            other.renderBufferMemoryId = GpuMemory::NONE;
+        }
+        return *this;
+    }
 
     static FrameBuffer getDefault() {
         FrameBuffer defaultFrameBuffer;
@@ -21,13 +57,15 @@ public:
         return defaultFrameBuffer;
     }
 
-    void generate(unsigned int width, unsigned int height) {
+    // name is what the color and depth/stencil attachments are listed as in GpuMemory
+    void generate(unsigned int width, unsigned int height, const std::string& name = "framebuffer") {
+        release();
         this->width = width;
         this->height = height;
 
         // Creates the framebuffer
         glGenFramebuffers(1, &id);
-        glBindFramebuffer(GL_FRAMEBUFFER, id);
+        GLState::bindFramebuffer(id);
         glViewport(0, 0, width, height);
 
         // Creates the color texture associated with the framebuffer
@@ -35,13 +73,15 @@ public:
         texture.imageFormat = GL_RGBA;
         texture.generate(width, height, nullptr);
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.id, 0);
+        GpuMemory::describe(texture.memoryId, GpuMemoryCategory_RenderTargets, name + " color");
 
         // Create Render Buffer Object
-        unsigned int RBO;
-        glGenRenderbuffers(1, &RBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, RBO);
+        glGenRenderbuffers(1, &renderBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderBuffer);
         glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, RBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderBuffer);
+        renderBufferMemoryId = GpuMemory::track(GpuMemoryCategory_RenderTargets, name + " depth/stencil",
+            GpuMemory::getFormatName(GL_DEPTH24_STENCIL8), GpuMemory::getTextureBytes(GL_DEPTH24_STENCIL8, width, height, false));
 
         // Check if framebuffer was created
         GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
@@ -50,15 +90,33 @@ public:
         }
 
         // Unbind framebuffer and texture
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLState::bindFramebuffer(0);
+        GLState::bindTexture(0);
     }
 
     void bind() {
-        glBindFramebuffer(GL_FRAMEBUFFER, id);
+        GLState::bindFramebuffer(id);
     }
 
     void unbind() {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GLState::bindFramebuffer(0);
+    }
+
+private:
+    GLuint renderBuffer;
+    GpuMemory::ResourceId renderBufferMemoryId;
+
+    // The color texture is released by its own destructor or replaced by the next generate()
+    void release() {
+        if (renderBuffer != 0) {
+            glDeleteRenderbuffers(1, &renderBuffer);
+            renderBuffer = 0;
+        }
+        GpuMemory::untrack(renderBufferMemoryId);
+        if (id != 0) {
+            GLState::forgetFramebuffer(id);
+            glDeleteFramebuffers(1, &id);
+            id = 0;
+        }
     }
 };
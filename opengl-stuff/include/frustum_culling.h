@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// SSE is used wherever the compiler targets it (every x64 build), define FRUSTUM_CULLING_SCALAR to
+// build the plain version instead
+#if !defined(FRUSTUM_CULLING_SCALAR) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define FRUSTUM_CULLING_SSE
+#endif
+
+// World space bounds of a set of objects, one entry per object, stored as a structure of arrays so
+// the planes are tested against four objects at a time. The sphere and the box share their center.
+struct CullingBounds {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> radius;
+    // half the size of the axis-aligned box
+    std::vector<float> extentX, extentY, extentZ;
+
+    void clear();
+    // adds the bounds of an object given in object space (bounding sphere and box around center),
+    // transformed by its model matrix
+    void add(const glm::mat4& model, const glm::vec3& center, float radius, const glm::vec3& extent);
+    size_t size() const;
+};
+
+// A static class that tests the bounds of many objects against the six planes of a view frustum.
+// Each plane is tested against both the sphere and the box of an object and the tighter one decides,
+// so long thin objects are culled by their box and rotated compact ones by their sphere.
+class FrustumCulling
+{
+public:
+    // planes of the frustum of viewProjection (Gribb and Hartmann), normals pointing inwards and
+    // normalized so distances are in world units
+    static void extractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+    // sets visible[i] to 1 when object i may intersect the frustum and 0 when it is entirely outside,
+    // returns the number of visible objects
+    static size_t cull(const glm::vec4 planes[6], const CullingBounds& bounds, std::vector<uint8_t>& visible);
+    // whether cull() tests four objects per instruction
+    static bool isVectorized();
+private:
+    // private constructor, all functions are static
+    FrustumCulling() { }
+};
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "geometry_arena.h"
+#include "index_packing.hpp"
+#include "vertex_format.hpp"
+
+// GPU storage of one mesh plus the CPU copy of its positions and indices used for picking.
+// The vertices and indices live in a range of the GeometryArena pool of their layout, so meshes
+// do not own buffers or a VAO. Instances are shared through GeometryRegistry, so objects with
+// identical geometry use a single range. The range is freed when the last reference goes away.
+// The vertices are uploaded in one of the VertexFormat layouts, the CPU copy always stays in floats.
+// The index lists of the LOD levels (MeshData::lodIndices) follow the full mesh in the same index
+// range and draw the same vertices.
+class Geometry {
+public:
+    Geometry(const std::vector<glm::vec3>& vertices,
+        const std::vector<glm::vec2>& texCoords,
+        const std::vector<glm::vec3>& normals,
+        const std::vector<GLuint>& indices,
+        VertexFormat format = VertexFormat_Float,
+        const std::vector<GLuint>& lodIndices = std::vector<GLuint>(),
+        const std::vector<GLuint>& lodIndexCounts = std::vector<GLuint>()) : format(format), positionScale(1.0f), positionOffset(0.0f),
+        texCoordsPresent(!texCoords.empty()), vertices(vertices), indices(indices) {
+
+        indexCount = static_cast<GLsizei>(indices.size());
+        computeBounds();
+
+        // LOD 0 is the full mesh, the other levels are appended to its indices
+        std::vector<GLuint> allIndices = indices;
+        lods.push_back({ 0, indices.size(), 0 });
+        size_t lodStart = 0;
+        for (GLuint lodIndexCount : lodIndexCounts) {
+            if (lodStart + lodIndexCount > lodIndices.size()) {
+                break;
+            }
+            lods.push_back({ allIndices.size(), lodIndexCount, 0 });
+            allIndices.insert(allIndices.end(), lodIndices.begin() + lodStart, lodIndices.begin() + lodStart + lodIndexCount);
+            lodStart += lodIndexCount;
+        }
+
+        if (format == VertexFormat_Compressed) {
+            uploadCompressed(vertices, texCoords, normals, allIndices);
+        } else {
+            uploadFloat(vertices, texCoords, normals, allIndices);
+        }
+    }
+
+    ~Geometry() {
+        GeometryArena::release(allocation);
+    }
+
+    Geometry(const Geometry&) = delete;
+    Geometry& operator=(const Geometry&) = delete;
+
+    // Binds the VAO shared by every geometry of the same layout
+    void bind() {
+        GeometryArena::bind(allocation);
+    }
+
+    // Draws instances of the triangles of a LOD level, bind() and GeometryArena::bindInstances() must
+    // have been called for this layout
+    void draw(size_t lod = 0, size_t instanceCount = 1) {
+        const IndexPart& range = lods[lod < lods.size() ? lod : lods.size() - 1];
+        drawRange(range.firstIndex, range.indexCount, instanceCount);
+    }
+
+    // Draws indexCount indices from firstIndex on, such as a run of meshlets of the full mesh (LOD 0
+    // comes first in the index range, so its indices keep their position)
+    void drawRange(size_t firstIndex, size_t indexCount, size_t instanceCount = 1) {
+        if (parts.empty()) {
+            GeometryArena::draw(allocation, { firstIndex, indexCount, 0 }, instanceCount);
+            return;
+        }
+        // A split mesh draws the pieces of its parts that fall into the range
+        const size_t rangeEnd = firstIndex + indexCount;
+        for (const IndexPart& part : parts) {
+            size_t first = std::max(firstIndex, part.firstIndex);
+            size_t end = std::min(rangeEnd, part.firstIndex + part.indexCount);
+            if (first < end) {
+                GeometryArena::draw(allocation, { first, end - first, part.baseVertex }, instanceCount);
+            }
+        }
+    }
+
+    GLsizei getIndexCount() {
+        return this->indexCount;
+    }
+
+    GeometryArena::AllocationId getAllocation() {
+        return this->allocation;
+    }
+
+    // Geometries of the same pool share their VAO, see GeometryArena
+    size_t getPool() {
+        return GeometryArena::getPool(allocation);
+    }
+
+    // Number of LOD levels, the full mesh included
+    size_t getLodCount() {
+        return this->lods.size();
+    }
+
+    size_t getLodIndexCount(size_t lod) {
+        return lod < lods.size() ? lods[lod].indexCount : 0;
+    }
+
+    // Bounding sphere of the vertices, in object space
+    const glm::vec3& getBoundsCenter() {
+        return this->boundsCenter;
+    }
+
+    float getBoundsRadius() {
+        return this->boundsRadius;
+    }
+
+    // Half the size of the bounding box, which is centered on the sphere
+    const glm::vec3& getBoundsExtent() {
+        return this->boundsExtent;
+    }
+
+    // GL_UNSIGNED_SHORT unless the mesh has too many vertices for 16-bit indices
+    GLenum getIndexType() {
+        return this->indexType;
+    }
+
+    // Bytes of index data uploaded, LOD levels included
+    size_t getIndexBufferSize() {
+        return this->indexBufferSize;
+    }
+
+    bool hasTexCoords() {
+        return this->texCoordsPresent;
+    }
+
+    VertexFormat getFormat() {
+        return this->format;
+    }
+
+    // Dequantization of the positions, object space = attribute * scale + offset (identity for float)
+    const glm::vec3& getPositionScale() {
+        return this->positionScale;
+    }
+
+    const glm::vec3& getPositionOffset() {
+        return this->positionOffset;
+    }
+
+    // Bytes of vertex attribute data uploaded, indices excluded
+    size_t getVertexBufferSize() {
+        return this->vertexBufferSize;
+    }
+
+    const std::vector<glm::vec3>& getVertices() {
+        return this->vertices;
+    }
+
+    const std::vector<GLuint>& getIndices() {
+        return this->indices;
+    }
+
+private:
+    GeometryArena::AllocationId allocation;
+    GLsizei indexCount;
+    GLenum indexType;
+    size_t indexBufferSize;
+    // draw calls of a mesh split to keep 16-bit indices, empty when it is drawn at once
+    std::vector<IndexPart> parts;
+    // index range of each LOD level (baseVertex unused), level 0 is the full mesh
+    std::vector<IndexPart> lods;
+    glm::vec3 boundsCenter;
+    float boundsRadius;
+    glm::vec3 boundsExtent;
+    VertexFormat format;
+    glm::vec3 positionScale;
+    glm::vec3 positionOffset;
+    bool texCoordsPresent;
+    size_t vertexBufferSize;
+    std::vector<glm::vec3> vertices;
+    std::vector<GLuint> indices;
+
+    // Bounding box, and a sphere around its center, loose but cheap
+    void computeBounds() {
+        glm::vec3 minimum(0.0f), maximum(0.0f);
+        if (!vertices.empty()) {
+            minimum = maximum = vertices[0];
+        }
+        for (const glm::vec3& vertex : vertices) {
+            minimum = glm::min(minimum, vertex);
+            maximum = glm::max(maximum, vertex);
+        }
+        boundsCenter = (minimum + maximum) * 0.5f;
+        boundsExtent = (maximum - minimum) * 0.5f;
+        boundsRadius = 0.0f;
+        for (const glm::vec3& vertex : vertices) {
+            boundsRadius = std::max(boundsRadius, glm::length(vertex - boundsCenter));
+        }
+    }
+
+    void upload(const std::vector<unsigned char>& data, size_t vertexCount, const PackedIndices& packed) {
+        allocation = GeometryArena::allocate(format, texCoordsPresent, data.data(), vertexCount, packed.data(), packed.size(), packed.type);
+        vertexBufferSize = data.size();
+        indexType = packed.type;
+        indexBufferSize = packed.size() * packed.getIndexSize();
+        parts = packed.parts;
+    }
+
+    // Interleaved FloatVertex, without the texture coordinates when there are none
+    void uploadFloat(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec2>& texCoords, const std::vector<glm::vec3>& normals,
+        const std::vector<GLuint>& indices) {
+        const size_t stride = GeometryArena::getVertexStride(VertexFormat_Float, !texCoords.empty());
+        PackedIndices packed = packIndices(indices, vertices.size(), stride);
+        const size_t vertexCount = packed.getVertexCount(vertices.size());
+        std::vector<unsigned char> data(vertexCount * stride);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            size_t source = packed.vertexOrder.empty() ? i : packed.vertexOrder[i];
+            FloatVertex vertex = { vertices[source], normals[source], texCoords.empty() ? glm::vec2(0.0f) : texCoords[source] };
+            std::memcpy(data.data() + i * stride, &vertex, stride);
+        }
+        upload(data, vertexCount, packed);
+    }
+
+    // Interleaved CompressedVertex, without the texture coordinates when there are none
+    void uploadCompressed(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec2>& texCoords, const std::vector<glm::vec3>& normals,
+        const std::vector<GLuint>& indices) {
+        glm::vec3 positionMin(0.0f), positionMax(0.0f);
+        if (!vertices.empty()) {
+            positionMin = positionMax = vertices[0];
+        }
+        for (const glm::vec3& vertex : vertices) {
+            positionMin = glm::min(positionMin, vertex);
+            positionMax = glm::max(positionMax, vertex);
+        }
+        glm::vec3 positionExtent = positionMax - positionMin;
+        positionOffset = positionMin;
+        positionScale = positionExtent;
+
+        const size_t stride = GeometryArena::getVertexStride(VertexFormat_Compressed, !texCoords.empty());
+        PackedIndices packed = packIndices(indices, vertices.size(), stride);
+        const size_t vertexCount = packed.getVertexCount(vertices.size());
+        std::vector<unsigned char> data(vertexCount * stride);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            size_t source = packed.vertexOrder.empty() ? i : packed.vertexOrder[i];
+            CompressedVertex vertex = compressVertex(vertices[source], normals[source], texCoords.empty() ? glm::vec2(0.0f) : texCoords[source],
+                positionMin, positionExtent);
+            std::memcpy(data.data() + i * stride, &vertex, stride);
+        }
+        upload(data, vertexCount, packed);
+    }
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "gpu_memory.h"
+#include "index_packing.hpp"
+#include "range_allocator.hpp"
+#include "vertex_format.hpp"
+
+// Per-instance attributes of the arena draws, tightly packed in the buffer given to GeometryArena::bindInstances()
+struct InstanceAttributes {
+    glm::mat4 model;
+    // inverse transpose of the upper 3x3 of model, carries the normals into world space
+    glm::mat3 normalMatrix;
+};
+
+// A static class that stores the vertices and indices of every Geometry in a few large buffers.
+// There is one pool per vertex layout (format, with or without texture coordinates) holding a
+// single VAO, vertex buffer and index buffer. Each geometry owns a range of vertices and a range
+// of indices inside its pool. Indices stay local to the mesh and are drawn with
+// glDrawElementsBaseVertex, so every mesh of a pool is drawn with the same VAO bound. The index
+// buffer mixes 16 and 32-bit indices, the type is recorded per allocation and index ranges are
+// allocated in 4-byte words so both stay aligned.
+// Every draw is instanced: the model and normal matrices of each instance are vertex attributes of
+// divisor 1 (the four locations from INSTANCE_MODEL_ATTRIBUTE and the three from
+// INSTANCE_NORMAL_ATTRIBUTE), read from the InstanceAttributes given to bindInstances().
+// Full pools grow by relocating their live ranges into larger buffers. compact() packs pools that
+// deleted objects left mostly empty or fragmented, the same way.
+// Uploads GL buffers, so it must only be used from the thread that owns the GL context.
+class GeometryArena
+{
+public:
+    typedef size_t AllocationId;
+    // first of the four vec4 attributes holding the per-instance model matrix
+    static const GLuint INSTANCE_MODEL_ATTRIBUTE = 3;
+    // first of the three vec3 attributes holding the per-instance normal matrix
+    static const GLuint INSTANCE_NORMAL_ATTRIBUTE = 7;
+
+    // uploads interleaved vertices in the layout of format and texCoords, and mesh-local indices
+    // of indexType (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT)
+    static AllocationId allocate(VertexFormat format, bool texCoords, const void* vertices, size_t vertexCount,
+        const void* indices, size_t indexCount, GLenum indexType);
+    // frees the ranges of an allocation, the space is reused by later allocations or packed by compact()
+    static void release(AllocationId allocation);
+    // pool holding the allocation, the allocations of a pool are drawn with the same VAO
+    static size_t getPool(AllocationId allocation);
+    // binds the VAO of the pool holding the allocation
+    static void bind(AllocationId allocation);
+    // points the per-instance attributes of the bound VAO at tightly packed InstanceAttributes in
+    // buffer, from offset on (a multiple of 4)
+    static void bindInstances(GLuint buffer, size_t offset);
+    // draws instanceCount instances of the triangles of an allocation, the VAO of its pool must be bound
+    static void draw(AllocationId allocation, size_t instanceCount = 1);
+    // draws one part of a split allocation, see IndexPart
+    static void draw(AllocationId allocation, const IndexPart& part, size_t instanceCount = 1);
+    // packs the pools that are mostly free, meant to be called once per frame
+    static void compact();
+    // bytes of GL buffer storage held by the pools, free ranges included
+    static size_t getBufferMemory();
+    // number of pools with buffers, which is the number of VAOs the scene is drawn with
+    static size_t getPoolCount();
+    // bytes per vertex of a layout
+    static size_t getVertexStride(VertexFormat format, bool texCoords);
+private:
+    // private constructor, all functions are static
+    GeometryArena() { }
+
+    struct Pool {
+        GLuint VAO = 0;
+        GLuint VBO = 0;
+        GLuint EBO = 0;
+        VertexFormat format = VertexFormat_Float;
+        bool texCoords = false;
+        RangeAllocator vertices; // in vertices
+        RangeAllocator indices;  // in 4-byte words
+        GpuMemory::ResourceId vertexMemoryId = GpuMemory::NONE;
+        GpuMemory::ResourceId indexMemoryId = GpuMemory::NONE;
+    };
+
+    struct Allocation {
+        size_t pool;
+        size_t baseVertex;
+        size_t vertexCount;
+        size_t firstWord;
+        size_t wordCount;
+        size_t indexCount;
+        GLenum indexType;
+        bool live;
+    };
+
+    static size_t getPoolIndex(VertexFormat format, bool texCoords);
+    // moves every live range of the pool, packed, into new buffers of the given capacities
+    static void relocate(size_t poolIndex, size_t vertexCapacity, size_t indexCapacity);
+    static void setupAttributes(Pool& pool);
+
+    static std::vector<Pool> pools;
+    static std::vector<Allocation> allocations;
+    // ids of released allocations, reused before the table grows
+    static std::vector<AllocationId> freeIds;
+};
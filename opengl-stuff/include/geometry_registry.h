@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "geometry.hpp"
+
+// A static class that hands out shared Geometry instances keyed by a hash of their content.
+// Meshes with byte-identical vertex and index data (the same model imported twice, or two files
+// that only differ in their materials) get the same GPU buffers. A matching hash is confirmed by
+// comparing the positions and indices the geometry keeps anyway, and a second, independent
+// checksum of the other streams, so a collision does not draw the wrong model. The registry only keeps weak
+// references, a geometry is released as soon as no mesh uses it anymore.
+// New geometry is uploaded in the current vertex format, geometries of another format are never shared.
+// Uploads GL buffers, so it must only be used from the thread that owns the GL context.
+class GeometryRegistry
+{
+public:
+    // returns the live geometry with the same content, or uploads a new one
+    static std::shared_ptr<Geometry> acquire(const std::vector<glm::vec3>& vertices,
+        const std::vector<glm::vec2>& texCoords,
+        const std::vector<glm::vec3>& normals,
+        const std::vector<GLuint>& indices,
+        const std::vector<GLuint>& lodIndices = std::vector<GLuint>(),
+        const std::vector<GLuint>& lodIndexCounts = std::vector<GLuint>());
+    // number of geometries currently alive
+    static size_t getGeometryCount();
+    // number of acquire calls that reused a live geometry instead of uploading it again
+    static size_t getReuseCount();
+    // bytes of vertex attribute data held by the live geometries
+    static size_t getVertexMemory();
+    // layout of the geometries uploaded from now on, live geometries keep theirs
+    static void setVertexFormat(VertexFormat format);
+    static VertexFormat getVertexFormat();
+private:
+    // private constructor, all functions are static
+    GeometryRegistry() { }
+
+    struct Entry {
+        std::weak_ptr<Geometry> geometry;
+        // checksumContent() of the streams the geometry does not keep a CPU copy of
+        uint64_t checksum;
+        VertexFormat format;
+    };
+
+    // whether a live geometry holds this data: same positions and indices, same checksum of the rest
+    static bool matches(const Entry& entry, Geometry& geometry,
+        const std::vector<glm::vec3>& vertices,
+        const std::vector<GLuint>& indices,
+        uint64_t checksum,
+        VertexFormat format);
+
+    static uint64_t hashContent(const std::vector<glm::vec3>& vertices,
+        const std::vector<glm::vec2>& texCoords,
+        const std::vector<glm::vec3>& normals,
+        const std::vector<GLuint>& indices,
+        const std::vector<GLuint>& lodIndices,
+        const std::vector<GLuint>& lodIndexCounts,
+        VertexFormat format);
+
+    static uint64_t checksumContent(const std::vector<glm::vec2>& texCoords,
+        const std::vector<glm::vec3>& normals,
+        const std::vector<GLuint>& lodIndices,
+        const std::vector<GLuint>& lodIndexCounts);
+
+    static std::unordered_map<uint64_t, Entry> geometries;
+    static size_t reuseCount;
+    static VertexFormat vertexFormat;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// A static class that shadows the GL state the viewer changes while drawing: the program, VAO,
+// active texture unit and 2D texture of each unit, draw framebuffer, blending, depth test and polygon
+// mode. Calls that would set the value already set are dropped before they reach the driver.
+// Code that changes this state must go through it, or call invalidate() afterwards. Deleting a
+// bound object resets the binding in GL, so deletions are reported with the forget functions.
+// ImGui restores the state it changes, but the shadow is invalidated at the end of every frame
+// anyway, so a stray call can only cost a frame of redundant binds.
+// Like the state it mirrors, it must only be used from the thread that owns the GL context.
+class GLState
+{
+public:
+    // texture units shadowed, binds to higher units always reach the driver
+    static const GLuint TEXTURE_UNITS = 16;
+
+    static void useProgram(GLuint program);
+    static void bindVertexArray(GLuint vertexArray);
+    // unit is an index, GL_TEXTURE0 + unit is made active
+    static void activeTexture(GLuint unit);
+    // binds a GL_TEXTURE_2D texture to the active unit
+    static void bindTexture(GLuint texture);
+    static void bindFramebuffer(GLuint framebuffer);
+    static void setBlend(bool enabled);
+    static void blendFunc(GLenum source, GLenum destination);
+    static void setDepthTest(bool enabled);
+    // polygon mode of front and back faces
+    static void polygonMode(GLenum mode);
+    // to call when objects are deleted, GL unbinds them and may hand their names out again
+    static void forgetProgram(GLuint program);
+    static void forgetVertexArray(GLuint vertexArray);
+    static void forgetTexture(GLuint texture);
+    static void forgetFramebuffer(GLuint framebuffer);
+    // forgets all shadowed state, the next call of every kind reaches the driver
+    static void invalidate();
+    // keeps the counters of the frame and starts counting the next one, invalidating the state
+    static void endFrame();
+    // calls passed to the driver and calls dropped during the last finished frame
+    static size_t getIssuedCalls();
+    static size_t getElidedCalls();
+private:
+    // private constructor, all functions are static
+    GLState() { }
+
+    // value of a binding or switch that has not been set since the last invalidate()
+    static const GLuint UNKNOWN = 0xFFFFFFFF;
+
+    // counts the call and returns whether it has to be issued, recording value as the new state
+    static bool change(GLuint& state, GLuint value);
+
+    static GLuint program;
+    static GLuint vertexArray;
+    static GLuint activeUnit;
+    static GLuint textures[TEXTURE_UNITS];
+    static GLuint framebuffer;
+    static GLuint blend;
+    static GLuint blendSource;
+    static GLuint blendDestination;
+    static GLuint depthTest;
+    static GLuint polygonModeState;
+    static size_t issuedCalls;
+    static size_t elidedCalls;
+    static size_t lastIssuedCalls;
+    static size_t lastElidedCalls;
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+#include "import_listener.hpp"
+#include "mesh_data.hpp"
+
+// A static class that reads glTF 2.0 files (.gltf with external or data: buffers, and binary .glb)
+// without Assimp.
+//
+// The .glb file (or the .bin buffers) is memory mapped and every accessor is copied straight from
+// the mapping into the mesh vectors: tightly packed float attributes and 32-bit indices take a single
+// memcpy, strided and narrower types a plain conversion loop. Embedded images are handed to the
+// decoder from the mapping as well, and stored in model.images under Assimp's "*<image>" name.
+// Like the Assimp path there is one mesh per primitive reference in the node hierarchy, and node
+// transforms are not applied.
+class GltfFileReader
+{
+public:
+    // whether the file is a .gltf or .glb this reader handles
+    static bool canRead(const std::string& filePath);
+    // reads meshes, materials and embedded images into model, false if the file cannot be read
+    // (external images are not decoded)
+    static bool read(const std::string& filePath, ModelData& model, ImportListener* listener = nullptr);
+private:
+    // private constructor, all functions are static
+    GltfFileReader() { }
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+// What a tracked GL allocation is used for
+enum GpuMemoryCategory_
+{
+    GpuMemoryCategory_Geometry,      // vertex and index buffers of the geometry arena
+    GpuMemoryCategory_Textures,      // material textures and font glyphs
+    GpuMemoryCategory_RenderTargets, // framebuffer color textures and depth/stencil renderbuffers
+    GpuMemoryCategory_Streaming,     // the stream buffer ring
+    GpuMemoryCategory_Count
+};
+typedef int GpuMemoryCategory;
+
+const char* const GPU_MEMORY_CATEGORY_NAMES[GpuMemoryCategory_Count] = { "Geometry", "Textures", "Render targets", "Streaming" };
+
+// One live GL allocation
+struct GpuResource {
+    GpuMemoryCategory category;
+    std::string name;
+    std::string format; // pixel format of textures and render targets, vertex layout of buffers
+    size_t bytes;
+};
+
+// A static class that keeps account of the GL memory the viewer allocates. Buffers, textures and
+// renderbuffers register their size when they are created and unregister it when they are deleted,
+// the totals are kept per category so reading them costs nothing.
+// Sizes are computed from dimensions and formats: drivers pad and align allocations, so the real
+// usage is somewhat higher, but the proportions hold.
+// Like the GL objects it follows, it must only be used from the thread that owns the GL context.
+class GpuMemory
+{
+public:
+    typedef size_t ResourceId;
+    // id held by handles that track nothing
+    static const ResourceId NONE = SIZE_MAX;
+
+    // registers an allocation of bytes and returns its id
+    static ResourceId track(GpuMemoryCategory category, const std::string& name, const std::string& format, size_t bytes);
+    // unregisters an allocation and resets id to NONE, does nothing for NONE
+    static void untrack(ResourceId& id);
+    // renames and recategorizes an allocation, for owners that know more than the code that created it
+    static void describe(ResourceId id, GpuMemoryCategory category, const std::string& name);
+    // bytes of all live allocations
+    static size_t getTotalBytes();
+    // highest total reached so far
+    static size_t getPeakBytes();
+    static size_t getCategoryBytes(GpuMemoryCategory category);
+    // bytes of a category per format, e.g. textures by pixel format
+    static std::map<std::string, size_t> getFormatBytes(GpuMemoryCategory category);
+    // the count largest live allocations, largest first
+    static std::vector<GpuResource> getLargestResources(size_t count);
+    // size of a texture or renderbuffer of internalFormat, with its full mipmap chain if mipmapped
+    static size_t getTextureBytes(GLenum internalFormat, unsigned int width, unsigned int height, bool mipmapped);
+    // short name of a texture or renderbuffer internal format, unsized formats are named as the 8-bit ones drivers pick
+    static const char* getFormatName(GLenum internalFormat);
+private:
+    // private constructor, all functions are static
+    GpuMemory() { }
+
+    struct Entry {
+        GpuResource resource;
+        bool live;
+    };
+
+    static std::vector<Entry> entries;
+    // ids of untracked allocations, reused before the table grows
+    static std::vector<ResourceId> freeIds;
+    static size_t categoryBytes[GpuMemoryCategory_Count];
+    static size_t totalBytes;
+    static size_t peakBytes;
+};
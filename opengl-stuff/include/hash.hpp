@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// 64-bit non-cryptographic hash of a byte range, used to fingerprint files and geometry.
+// Consumes 8 bytes per step, which keeps hashing a multi-megabyte model well below the cost of parsing it.
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ULL) {
+    const uint64_t prime = 0x100000001b3ULL;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed ^ (size * prime);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * prime;
+    }
+    // Final avalanche so close inputs spread over the whole range
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Second 64-bit fingerprint of a byte range, built differently from hashBytes (multiply-rotate
+// rounds and another finalizer), so inputs colliding in one are not expected to collide in the other.
+// Used to confirm a hashBytes match without keeping a copy of the data.
+inline uint64_t checksumBytes(const void* data, size_t size, uint64_t seed = 0x9e3779b97f4a7c15ULL) {
+    const uint64_t prime1 = 0x9e3779b185ebca87ULL;
+    const uint64_t prime2 = 0xc2b2ae3d27d4eb4fULL;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed + size * prime2;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash += word * prime2;
+        hash = (hash << 31 | hash >> 33) * prime1;
+    }
+    for (; i < size; ++i) {
+        hash += bytes[i] * prime1;
+        hash = (hash << 11 | hash >> 53) * prime2;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "mesh_data.hpp"
+
+// Receives the progress of an import, which allows running ObjectReader::loadModelData on a
+// background thread and showing its meshes while the rest is still being converted.
+class ImportListener {
+public:
+    virtual ~ImportListener() { }
+    // polled during the import, returning true stops it as soon as possible
+    virtual bool isCancelled() { return false; }
+    // overall progress of the import, from 0 to 1
+    virtual void onProgress(float /*progress*/) { }
+    // materials and decoded textures of the model, always reported before the first mesh
+    virtual void onMaterials(const ModelData& /*model*/) { }
+    // a mesh finished converting and is handed over, may be called from several pool threads at once
+    virtual void onMeshReady(MeshData&& /*mesh*/) { }
+};
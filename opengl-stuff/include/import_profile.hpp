@@ -0,0 +1,74 @@
+#pragma once
+
+#include <assimp/postprocess.h>
+#include <string>
+
+// Assimp post-processing presets a model can be imported with, chosen per object in scene JSON
+// ("profile") or in the import dialog. They trade load time against render cost:
+//  - fast: only triangulates, loads the quickest
+//  - optimized: welds identical vertices and merges meshes and nodes where the hierarchy allows
+//    it, then MeshOptimizer reorders triangles and vertices for the vertex cache and overdraw
+//    and builds the LOD levels the renderer switches to for distant objects
+//  - static-merged: bakes the node transforms into the vertices and merges everything that shares
+//    a material, the fewest draw calls for models that are not edited mesh by mesh, optimized by
+//    MeshOptimizer as well
+//  - clustered: optimized, plus meshlets the renderer culls separately, for large meshes that are
+//    often only partly in view or facing the camera
+enum ImportProfile_
+{
+	ImportProfile_Fast,
+	ImportProfile_Optimized,
+	ImportProfile_StaticMerged,
+	ImportProfile_Clustered,
+	ImportProfile_Count
+};
+typedef int ImportProfile;
+
+const char* const IMPORT_PROFILE_NAMES[ImportProfile_Count] = { "fast", "optimized", "static-merged", "clustered" };
+
+// Steps every profile reads the file with, the profile steps are applied on top of them
+const unsigned int IMPORT_BASE_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs;
+
+inline const char* getImportProfileName(ImportProfile profile) {
+	if (profile < 0 || profile >= ImportProfile_Count) {
+		return IMPORT_PROFILE_NAMES[ImportProfile_Fast];
+	}
+	return IMPORT_PROFILE_NAMES[profile];
+}
+
+// Finds the profile with the given name, returns false if there is none
+inline bool parseImportProfile(const std::string& name, ImportProfile& profile) {
+	for (int i = 0; i < ImportProfile_Count; ++i) {
+		if (name == IMPORT_PROFILE_NAMES[i]) {
+			profile = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Whether the converted meshes of a profile go through MeshOptimizer. Assimp's
+// ImproveCacheLocality is left out of those profiles, the optimizer does the same job and more.
+inline bool isMeshOptimizedProfile(ImportProfile profile) {
+	return profile == ImportProfile_Optimized || profile == ImportProfile_StaticMerged || profile == ImportProfile_Clustered;
+}
+
+// Whether the converted meshes of a profile are split into meshlets, see MeshOptimizer::buildMeshlets
+inline bool isMeshletProfile(ImportProfile profile) {
+	return profile == ImportProfile_Clustered;
+}
+
+// Post-processing steps of a profile, on top of IMPORT_BASE_FLAGS
+inline unsigned int getImportProfileFlags(ImportProfile profile) {
+	switch (profile) {
+	case ImportProfile_Optimized:
+	case ImportProfile_Clustered:
+		return aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph;
+	case ImportProfile_StaticMerged:
+		// PreTransformVertices replaces OptimizeGraph, Assimp refuses to run both
+		return aiProcess_JoinIdenticalVertices | aiProcess_OptimizeMeshes
+			| aiProcess_PreTransformVertices | aiProcess_RemoveRedundantMaterials;
+	default:
+		return 0;
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+
+// Largest vertex count a 16-bit index can address
+const size_t MAX_INDEX16_VERTICES = 65536;
+// Meshes up to this many vertices are split into 16-bit parts when that takes less memory
+const size_t MAX_SPLIT_VERTICES = 4 * MAX_INDEX16_VERTICES;
+
+// Triangles of a mesh drawn with one base vertex: firstIndex and baseVertex are relative to the
+// start of the mesh's index and vertex ranges
+struct IndexPart {
+    size_t firstIndex;
+    size_t indexCount;
+    size_t baseVertex;
+};
+
+// The indices of a mesh in the smallest type that can address them. A mesh with more than
+// MAX_INDEX16_VERTICES vertices keeps 16-bit indices by being split into parts of at most that
+// many vertices. Each part gets its own copy of the vertices it uses (vertexOrder lists the source
+// vertex of every uploaded vertex), so the split is only kept when it is smaller than 32-bit indices.
+struct PackedIndices {
+    GLenum type = GL_UNSIGNED_INT;
+    std::vector<uint16_t> indices16;
+    std::vector<GLuint> indices32;
+    std::vector<GLuint> vertexOrder; // empty when the vertices are uploaded in their original order
+    std::vector<IndexPart> parts;    // empty when the whole mesh is drawn at once
+
+    const void* data() const {
+        return type == GL_UNSIGNED_SHORT ? static_cast<const void*>(indices16.data()) : static_cast<const void*>(indices32.data());
+    }
+
+    size_t size() const {
+        return type == GL_UNSIGNED_SHORT ? indices16.size() : indices32.size();
+    }
+
+    size_t getIndexSize() const {
+        return type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(GLuint);
+    }
+
+    size_t getVertexCount(size_t sourceVertexCount) const {
+        return vertexOrder.empty() ? sourceVertexCount : vertexOrder.size();
+    }
+};
+
+// Splits the triangles, in order, into parts that use at most MAX_INDEX16_VERTICES vertices each
+inline void splitIndices16(const std::vector<GLuint>& indices, size_t vertexCount, PackedIndices& packed) {
+    const uint32_t NOT_SEEN = UINT32_MAX;
+    std::vector<uint32_t> partOfVertex(vertexCount, NOT_SEEN);
+    std::vector<uint16_t> localIndex(vertexCount);
+    packed.indices16.clear();
+    packed.indices16.reserve(indices.size());
+    packed.vertexOrder.clear();
+    packed.parts.clear();
+
+    IndexPart part = { 0, 0, 0 };
+    uint32_t partId = 0;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        size_t newVertices = 0;
+        for (size_t corner = 0; corner < 3; ++corner) {
+            GLuint vertex = indices[i + corner];
+            bool repeated = (corner > 0 && indices[i] == vertex) || (corner > 1 && indices[i + 1] == vertex);
+            if (partOfVertex[vertex] != partId && !repeated) {
+                ++newVertices;
+            }
+        }
+        if (packed.vertexOrder.size() - part.baseVertex + newVertices > MAX_INDEX16_VERTICES) {
+            part.indexCount = packed.indices16.size() - part.firstIndex;
+            packed.parts.push_back(part);
+            part = { packed.indices16.size(), 0, packed.vertexOrder.size() };
+            ++partId;
+        }
+        for (size_t corner = 0; corner < 3; ++corner) {
+            GLuint vertex = indices[i + corner];
+            if (partOfVertex[vertex] != partId) {
+                partOfVertex[vertex] = partId;
+                localIndex[vertex] = static_cast<uint16_t>(packed.vertexOrder.size() - part.baseVertex);
+                packed.vertexOrder.push_back(vertex);
+            }
+            packed.indices16.push_back(localIndex[vertex]);
+        }
+    }
+    part.indexCount = packed.indices16.size() - part.firstIndex;
+    packed.parts.push_back(part);
+}
+
+/**
+ * Picks the index type of a mesh: 16-bit when it has few enough vertices, 16-bit split into parts
+ * when it is only slightly over and the duplicated vertices cost less than the saved index bytes,
+ * 32-bit otherwise.
+ *
+ * @param indices The triangle list, indexing vertexCount vertices.
+ * @param vertexCount Number of vertices of the mesh.
+ * @param vertexStride Bytes per uploaded vertex, to weigh duplicated vertices against index bytes.
+ */
+inline PackedIndices packIndices(const std::vector<GLuint>& indices, size_t vertexCount, size_t vertexStride) {
+    PackedIndices packed;
+    if (vertexCount <= MAX_INDEX16_VERTICES) {
+        packed.type = GL_UNSIGNED_SHORT;
+        packed.indices16.assign(indices.begin(), indices.end());
+        return packed;
+    }
+    if (vertexCount <= MAX_SPLIT_VERTICES && indices.size() % 3 == 0) {
+        splitIndices16(indices, vertexCount, packed);
+        size_t splitBytes = packed.vertexOrder.size() * vertexStride + packed.indices16.size() * sizeof(uint16_t);
+        size_t wholeBytes = vertexCount * vertexStride + indices.size() * sizeof(GLuint);
+        if (splitBytes < wholeBytes) {
+            packed.type = GL_UNSIGNED_SHORT;
+            return packed;
+        }
+        packed = PackedIndices();
+    }
+    packed.indices32 = indices;
+    return packed;
+}
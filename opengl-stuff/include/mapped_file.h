@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+// The mapping lives as long as the object, so pointers into data() must not outlive it.
+class MappedFile {
+public:
+    MappedFile() { }
+    explicit MappedFile(const std::string& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // maps the file, returns false if it does not exist or cannot be mapped
+    bool open(const std::string& path);
+    // unmaps the file
+    void close();
+
+    bool isOpen() const { return opened; }
+    const unsigned char* data() const { return this->bytes; }
+    size_t size() const { return this->length; }
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <glm/glm.hpp>
 #include "texture.h"
 
@@ -11,8 +12,15 @@ public:
 	glm::vec3 emissiveColor;
 	float shininess;
 	float opacity;
-	Texture2D texture;
+	Texture2D* texture; // owned by ResourceManager, null until the texture is loaded or when there is none
+	std::string texturePath; // texture path as written in the model file, relative to it
 
-	Material(): ambientColor(glm::vec3(1.0f)), diffuseColor(glm::vec3(1.0f)), specularColor(glm::vec3(1.0f)), emissiveColor(glm::vec3(1.0f)), shininess(1.0f), opacity(1.0f) { }
+	Material(): ambientColor(glm::vec3(1.0f)), diffuseColor(glm::vec3(1.0f)), specularColor(glm::vec3(1.0f)), emissiveColor(glm::vec3(1.0f)), shininess(1.0f), opacity(1.0f), texture(nullptr) { }
+
+	// Whether both draw the same, e.g. the materials of two imports of one model
+	bool looksLike(const Material& other) const {
+		return ambientColor == other.ambientColor && diffuseColor == other.diffuseColor && specularColor == other.specularColor
+			&& emissiveColor == other.emissiveColor && shininess == other.shininess && opacity == other.opacity && texture == other.texture;
+	}
 
 };
\ No newline at end of file
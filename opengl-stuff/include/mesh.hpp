@@ -1,9 +1,13 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <glad/glad.h>
 
+#include "geometry.hpp"
+#include "geometry_registry.h"
 #include "material.hpp"
+#include "mesh_data.hpp"
 
 class Mesh {
 public:
@@ -11,100 +15,150 @@ public:
         const std::vector<glm::vec2>& texCoords,
         const std::vector<glm::vec3>& normals,
         const std::vector<GLuint>& indices,
-        Material material, std::string name) : Mesh(vertices, normals, indices, material, name) {
+        std::shared_ptr<Material> material, std::string name) {
 
-        glGenBuffers(1, &TBO);
-        glBindVertexArray(VAO);
-
-        // Texture
-        glBindBuffer(GL_ARRAY_BUFFER, TBO);
-        glBufferData(GL_ARRAY_BUFFER, texCoords.size() * sizeof(glm::vec2), texCoords.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(1);
-
-        // Unbind
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+        // Meshes with identical data share the same buffers
+        this->geometry = GeometryRegistry::acquire(vertices, texCoords, normals, indices);
+        this->material = material;
+        this->name = name;
     }
 
     Mesh(const std::vector<glm::vec3>& vertices,
         const std::vector<glm::vec3>& normals,
         const std::vector<GLuint>& indices,
-        Material material, std::string name) {
+        std::shared_ptr<Material> material, std::string name) : Mesh(vertices, std::vector<glm::vec2>(), normals, indices, material, name) { }
 
-        vertexCount = static_cast<GLsizei>(indices.size());
+    // A converted mesh, with its LOD levels and meshlets
+    Mesh(const MeshData& data, std::shared_ptr<Material> material) {
+        this->geometry = GeometryRegistry::acquire(data.vertices, data.texCoords, data.normals, data.indices, data.lodIndices, data.lodIndexCounts);
         this->material = material;
-        this->vertices = vertices;
-        this->indices = indices;
-        this->name = name;
+        this->name = data.name;
+        this->meshlets = data.meshlets;
+        this->closed = data.closed;
+    }
 
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &NBO);
-        glGenBuffers(1, &EBO);
+    // A mesh is a handle to shared GL buffers, it moves into its Object3D and is never copied
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
 
-        glBindVertexArray(VAO);
+    void bind() {
+        geometry->bind();
+    }
 
-        // Vertices
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(0);
+    // Draws instances of the triangles of the current LOD level with the layout's VAO bound by bind(),
+    // their model and normal matrices come from GeometryArena::bindInstances()
+    void draw(size_t instanceCount = 1) {
+        geometry->draw(lod, instanceCount);
+    }
 
-        // Normals
-        glBindBuffer(GL_ARRAY_BUFFER, NBO);
-        glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(2);
+    // Draws part of the full resolution triangles, such as a run of meshlets
+    void drawRange(size_t firstIndex, size_t indexCount, size_t instanceCount = 1) {
+        geometry->drawRange(firstIndex, indexCount, instanceCount);
+    }
 
-        // Indexes
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
-        glEnableVertexAttribArray(3);
+    GLsizei getVertexCount() {
+        return geometry->getIndexCount();
+    }
 
-        // Unbind
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindVertexArray(0);
+    // Number of LOD levels, 1 when the mesh only has its full resolution
+    size_t getLodCount() {
+        return geometry->getLodCount();
     }
 
-    void bind() {
-        glBindVertexArray(VAO);
+    size_t getLodTriangleCount(size_t lod) {
+        return geometry->getLodIndexCount(lod) / 3;
     }
 
-    GLsizei getVertexCount() {
-        return this->vertexCount;
+    // Level draw() uses, kept per mesh so each object switches levels on its own (see Renderer)
+    size_t getLod() {
+        return this->lod;
+    }
+
+    void setLod(size_t lod) {
+        this->lod = lod < getLodCount() ? lod : getLodCount() - 1;
+    }
+
+    // Meshlets of the full resolution triangles, empty unless the import profile builds them
+    const std::vector<Meshlet>& getMeshlets() {
+        return this->meshlets;
+    }
+
+    // Whether the surface is closed, see MeshData::closed
+    bool isClosed() {
+        return this->closed;
+    }
+
+    // Bounding sphere in object space
+    const glm::vec3& getBoundsCenter() {
+        return geometry->getBoundsCenter();
+    }
+
+    float getBoundsRadius() {
+        return geometry->getBoundsRadius();
     }
 
+    // Half the size of the bounding box around getBoundsCenter(), in object space
+    const glm::vec3& getBoundsExtent() {
+        return geometry->getBoundsExtent();
+    }
+
+    VertexFormat getVertexFormat() {
+        return geometry->getFormat();
+    }
+
+    // Identifies the geometry, which meshes holding the same data share
+    GeometryArena::AllocationId getGeometryId() {
+        return geometry->getAllocation();
+    }
+
+    // Meshes of the same pool are drawn with the same VAO bound
+    size_t getPool() {
+        return geometry->getPool();
+    }
+
+    // Dequantization the vertex shader applies to the positions
+    const glm::vec3& getPositionScale() {
+        return geometry->getPositionScale();
+    }
+
+    const glm::vec3& getPositionOffset() {
+        return geometry->getPositionOffset();
+    }
+
+    // The material may be shared with other meshes of the same model
     Material& getMaterial() {
-        return this->material;
+        return *this->material;
     }
 
-    std::vector<glm::vec3>& getVertices() {
-        return this->vertices;
+    // Gives the mesh its own copy of the material first when it is shared, so changes to it
+    // only affect this mesh
+    Material& getOwnMaterial() {
+        if (this->material.use_count() > 1) {
+            this->material = std::make_shared<Material>(*this->material);
+        }
+        return *this->material;
     }
 
-    std::vector<GLuint>& getIndices() {
-        return this->indices;
+    // The geometry may be shared with other meshes holding the same data
+    const std::vector<glm::vec3>& getVertices() {
+        return geometry->getVertices();
     }
 
-    std::string getName() {
-        return this->name;
+    const std::vector<GLuint>& getIndices() {
+        return geometry->getIndices();
     }
 
-    void deleteBuffers() {
-        glDeleteBuffers(1, &VBO);
-        glDeleteBuffers(1, &NBO);
-        glDeleteBuffers(1, &TBO);
-        glDeleteBuffers(1, &EBO);
-        glDeleteVertexArrays(1, &VAO);
+    const std::string& getName() {
+        return this->name;
     }
 
 private:
-    GLuint VAO, VBO, NBO, TBO, EBO;
-    GLsizei vertexCount;
-    std::vector<glm::vec3> vertices;
-    std::vector<GLuint> indices;
-    Material material;
+    std::shared_ptr<Geometry> geometry;
+    std::shared_ptr<Material> material;
     std::string name;
-};
\ No newline at end of file
+    size_t lod = 0;
+    std::vector<Meshlet> meshlets;
+    bool closed = false;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+#include "import_profile.hpp"
+#include "mesh_data.hpp"
+
+// A static class that stores converted models in a binary cache file next to the source asset
+// (<model path>.<profile>.meshcache), so repeated loads skip Assimp and the per-vertex conversion.
+// Every import profile has its own cache, since the profiles produce different geometry.
+//
+// The file starts with a versioned header holding the size, modification time and content hash of
+// the source file, followed by mesh and material records, the same size, time and hash of every
+// material library the source names, and the raw vertex/index arrays (LOD index lists included).
+// Arrays are 16-byte aligned so they can be read straight out of the memory mapped file.
+class MeshCache
+{
+public:
+    // path of the cache file that belongs to a model imported with a profile
+    static std::string getCachePath(const std::string& modelPath, ImportProfile profile);
+    // fills model from the cache if it exists and still matches the source file
+    static bool load(const std::string& modelPath, ImportProfile profile, ModelData& model);
+    // writes (or replaces) the cache for a model
+    static bool save(const std::string& modelPath, ImportProfile profile, const ModelData& model);
+    // turns the cache off (load misses, save does nothing), e.g. to measure cold imports
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+private:
+    // private constructor, all functions are static
+    MeshCache() { }
+
+    static bool enabled;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "material.hpp"
+
+// A run of neighbouring triangles of MeshData::indices (up to MeshOptimizer::MESHLET_TRIANGLES) with
+// the bounds the renderer culls it with, in object space. The normal cone holds the normals of every
+// triangle, so the whole meshlet faces away from a camera at eye when
+// dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius.
+struct Meshlet {
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneAxis;
+    float coneCutoff;   // 1 when the normals spread too far for the meshlet to ever face away
+    GLuint firstIndex;
+    GLuint indexCount;
+};
+
+// CPU side geometry of a mesh, produced by the import stage before anything is sent to OpenGL.
+// It holds no GL objects, so it can be built on any thread and uploaded later on the context thread.
+struct MeshData {
+    std::string name;
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec2> texCoords; // empty when the source mesh has no texture coordinates
+    std::vector<glm::vec3> normals;
+    std::vector<GLuint> indices;
+    // Simplified versions of indices over the same vertices (LOD 1 and up, each coarser than the
+    // one before), stored back to back. lodIndexCounts holds the size of each level.
+    std::vector<GLuint> lodIndices;
+    std::vector<GLuint> lodIndexCounts;
+    // Partition of indices into meshlets, in index order. Empty unless the import profile builds them.
+    std::vector<Meshlet> meshlets;
+    // Whether every edge is shared by two triangles of opposite winding (positions compared), so
+    // back faces are never visible and meshlets facing away can be culled. Set with the meshlets.
+    bool closed = false;
+    unsigned int materialIndex = 0;
+};
+
+// Everything the import produces for one model file: converted meshes plus their materials.
+// Materials only carry the texture path here, the GL stage creates the textures from the
+// images decoded during the import (keyed by texture path).
+struct ModelData {
+    std::vector<MeshData> meshes;
+    std::vector<Material> materials;
+    std::map<std::string, ImageData> images;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "mesh_data.hpp"
+
+// Post-transform vertex cache behaviour of a triangle list, simulated with a FIFO cache
+struct VertexCacheStats {
+    size_t triangles = 0;
+    size_t vertices = 0;  // distinct vertices referenced
+    size_t misses = 0;    // vertices the GPU has to transform
+
+    // average cache miss ratio, transformed vertices per triangle (0.5 is the best a grid can get)
+    float getACMR() const {
+        return triangles > 0 ? static_cast<float>(misses) / triangles : 0.0f;
+    }
+
+    // average transformed vertex ratio, transformed vertices per vertex (1.0 is ideal)
+    float getATVR() const {
+        return vertices > 0 ? static_cast<float>(misses) / vertices : 0.0f;
+    }
+
+    void add(const VertexCacheStats& other) {
+        triangles += other.triangles;
+        vertices += other.vertices;
+        misses += other.misses;
+    }
+};
+
+// A static class that reorders the triangles and vertices of converted meshes for rendering.
+//
+// optimize() runs three passes:
+//  - Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and
+//    Reduced Overdraw", 2007) orders the triangles for the post-transform vertex cache
+//  - the triangle sequence is cut into clusters where the cache starts over anyway, and the
+//    clusters are sorted so the ones facing outwards are drawn first, which lets the depth test
+//    reject more of the fragments behind them
+//  - vertices are renumbered in the order the triangles first use them, for fetch locality, and
+//    unused vertices are dropped
+// buildMeshlets() can then split the triangles into small patches the renderer culls one by one,
+// and generateLods() adds simplified index lists over the same vertices, see MeshData::lodIndices.
+// Touches no GL state, so it runs on the worker threads.
+class MeshOptimizer
+{
+public:
+    // entries of the simulated cache, a conservative size for the hardware the viewer runs on
+    static const unsigned int CACHE_SIZE = 16;
+    // most LOD levels generateLods() builds besides the full mesh
+    static const size_t MAX_LOD_COUNT = 3;
+    // most triangles of a meshlet, buildMeshlets() makes most of them 64 to 128 triangles
+    static const size_t MESHLET_TRIANGLES = 128;
+
+    // reorders the mesh in place, triangle lists only (other meshes are left as they are)
+    static void optimize(MeshData& mesh);
+    // partitions the triangles into meshlets of neighbouring triangles with similar normals and fills
+    // mesh.meshlets with their bounds, and mesh.closed. mesh.indices is regrouped meshlet by meshlet,
+    // run it after optimize(): triangles keep their order inside a meshlet.
+    static void buildMeshlets(MeshData& mesh);
+    // fills mesh.lodIndices with up to MAX_LOD_COUNT levels, each about half the triangles of the
+    // previous one, ordered for the vertex cache. Run after optimize(), which renumbers the vertices.
+    static void generateLods(MeshData& mesh);
+    /**
+     * Reduces a triangle list by collapsing edges in the order of their quadric error. Vertices
+     * only move onto their neighbours, so the result indexes the same vertices. Mesh borders and
+     * attribute seams are kept in place.
+     *
+     * @param indices The triangle list to simplify.
+     * @param vertices The positions the indices refer to.
+     * @param targetIndexCount Index count to stop at, the result can end up a little below it.
+     * @param targetError Largest error allowed, relative to the size of the mesh (0.01 is 1%).
+     * @param resultError Receives the largest error of the collapses made, same scale as targetError.
+     * @return The simplified triangle list, larger than targetIndexCount if the error limit was hit first.
+     */
+    static std::vector<GLuint> simplify(const std::vector<GLuint>& indices, const std::vector<glm::vec3>& vertices,
+        size_t targetIndexCount, float targetError, float* resultError = nullptr);
+    // simulates a FIFO vertex cache over the triangle list
+    static VertexCacheStats analyzeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, unsigned int cacheSize = CACHE_SIZE);
+private:
+    // private constructor, all functions are static
+    MeshOptimizer() { }
+};
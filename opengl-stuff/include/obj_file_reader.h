@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+
+#include "import_listener.hpp"
+#include "mesh_data.hpp"
+
+// A static class that reads Wavefront .obj files and their .mtl libraries without Assimp.
+//
+// The file is memory mapped and split into line-aligned chunks that are parsed in parallel on
+// the shared thread pool, then the meshes are assembled in parallel as well. The output matches
+// what ObjectReader produces through Assimp with the "fast" profile: one mesh per object/group
+// and material run, triangulated, UVs flipped, material 0 being Assimp's default material.
+// Vertices are welded on their (position, uv, normal) index triple while the meshes are built.
+class ObjFileReader
+{
+public:
+    // whether the file is an .obj this reader handles
+    static bool canRead(const std::string& filePath);
+    // reads meshes and materials into model (images are not decoded), false if the file cannot be read
+    static bool read(const std::string& filePath, ModelData& model, ImportListener* listener = nullptr);
+private:
+    // private constructor, all functions are static
+    ObjFileReader() { }
+};
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cmath>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <utility>
 
 #include "mesh.hpp"
 #include "texture.h"
@@ -11,13 +13,19 @@ class Object3D: public Transformable {
 public:
     Mesh mesh;
 
-    Object3D(Mesh &objMesh): Transformable(), mesh(objMesh) { }
+    // The geometry is released with the mesh, when the last object using it is deleted
+    Object3D(Mesh&& objMesh): Transformable(), mesh(std::move(objMesh)) { }
 
-    ~Object3D() {
-        this->mesh.deleteBuffers();
-    }
+    // Rebuilt only when the transform changed since the last call, most objects never move
+    const glm::mat4& getModelMatrix() {
+        if (this->position == cachedPosition && this->scale == cachedScale && this->origin == cachedOrigin && this->rotation == cachedRotation) {
+            return cachedModel;
+        }
+        cachedPosition = this->position;
+        cachedScale = this->scale;
+        cachedOrigin = this->origin;
+        cachedRotation = this->rotation;
 
-    glm::mat4 getModelMatrix() {
         glm::mat4 model = glm::mat4(1.0f);                                                           // identity
         model = glm::translate(model, this->position - this->origin);                                // position
         model = glm::translate(model, this->origin);                                                 // set origin
@@ -26,6 +34,15 @@ public:
         model = glm::rotate(model, rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));                         // rotation z
         model = glm::translate(model, glm::vec3(-this->origin.x, -this->origin.y, -this->origin.z)); // reset origin
         model = glm::scale(model, this->scale);                                                      // resize
-        return model;
+        cachedModel = model;
+        return cachedModel;
     }
+
+private:
+    // transform cachedModel was built from, NaN at first so the first call builds it
+    glm::vec3 cachedPosition = glm::vec3(NAN);
+    glm::vec3 cachedScale = glm::vec3(NAN);
+    glm::vec3 cachedOrigin = glm::vec3(NAN);
+    glm::vec3 cachedRotation = glm::vec3(NAN);
+    glm::mat4 cachedModel;
 };
@@ -3,16 +3,64 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <assimp/ProgressHandler.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <iostream>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <glm/glm.hpp>
 
 #include "object_3d.hpp"
+#include "geometry_registry.h"
+#include "gltf_file_reader.h"
+#include "import_listener.hpp"
+#include "import_profile.hpp"
 #include "material.hpp"
+#include "mesh_cache.h"
+#include "mesh_data.hpp"
+#include "mesh_optimizer.h"
+#include "obj_file_reader.h"
 #include "resource_manager.h"
+#include "thread_pool.hpp"
 
 namespace fs = std::filesystem;
 
+// Where the time of one import went, filled by ObjectReader for the last model it read
+struct ImportStats {
+    bool fromCache = false;
+    bool nativeParser = false;
+    double cacheMs = 0.0;
+    double parseMs = 0.0;    // Assimp read and post-processing, or the whole native read
+    double texturesMs = 0.0;
+    double convertMs = 0.0;  // aiMesh conversion, part of parseMs for the native reader
+    double uploadMs = 0.0;   // materials, textures and buffers, only when readModel created objects
+    size_t meshes = 0;
+    size_t vertices = 0;
+    size_t indices = 0;
+    size_t meshlets = 0;
+    // vertex cache behaviour before and after MeshOptimizer, only for profiles that run it
+    VertexCacheStats cacheBefore;
+    VertexCacheStats cacheAfter;
+
+    void add(const ImportStats& other) {
+        cacheMs += other.cacheMs;
+        parseMs += other.parseMs;
+        texturesMs += other.texturesMs;
+        convertMs += other.convertMs;
+        uploadMs += other.uploadMs;
+        meshes += other.meshes;
+        vertices += other.vertices;
+        indices += other.indices;
+        meshlets += other.meshlets;
+        cacheBefore.add(other.cacheBefore);
+        cacheAfter.add(other.cacheAfter);
+    }
+};
+
 class ObjectReader {
 public:
     ObjectReader() {
@@ -23,93 +71,462 @@ public:
         delete importer;
     }
 
-    std::vector<Object3D*> readModel(const char* filePath) {
-        const aiScene* scene = importer->ReadFile(filePath, aiProcess_Triangulate | aiProcess_FlipUVs);
+    std::vector<Object3D*> readModel(const char* filePath, ImportProfile profile = ImportProfile_Fast) {
+        std::vector<Object3D*> objects;
+        ModelData model;
+        if (!loadModelData(filePath, model, profile)) {
+            return objects;
+        }
+
+        // GL stage: create textures and upload the buffers on the context thread
+        auto uploadStart = Clock::now();
+        size_t reusedBefore = GeometryRegistry::getReuseCount();
+        MaterialList materials = createMaterials(model, filePath);
+        for (MeshData& meshData : model.meshes) {
+            objects.push_back(createObject(meshData, materials));
+        }
+        stats.uploadMs = elapsedMs(uploadStart, Clock::now());
+        std::cout << "ObjectReader: " << filePath << " upload " << stats.uploadMs << " ms"
+            << " (" << GeometryRegistry::getReuseCount() - reusedBefore << " of " << model.meshes.size() << " meshes shared existing geometry)" << std::endl;
+
+        return objects;
+    }
+
+    /**
+     * Runs the CPU part of the import: reads the model from its mesh cache when it is fresh,
+     * otherwise parses it (ObjFileReader for .obj and GltfFileReader for .gltf/.glb with the fast
+     * profile, Assimp for the rest), converts it and refreshes the cache. Textures referenced by the
+     * materials are decoded as well. Touches no GL state.
+     *
+     * @param filePath The path to the model file.
+     * @param model Receives the converted meshes, materials and decoded textures.
+     * @param profile The post-processing applied by Assimp, see ImportProfile.
+     * @param listener Optional receiver of progress and partial results. The meshes are handed
+     *                 over to it, model.meshes is left holding empty meshes.
+     * @return false if the model could not be read or the import was cancelled.
+     */
+    bool loadModelData(const char* filePath, ModelData& model, ImportProfile profile = ImportProfile_Fast, ImportListener* listener = nullptr) {
+        ThreadPool& pool = ThreadPool::shared();
+        const char* profileName = getImportProfileName(profile);
+        stats = ImportStats();
+
+        // glTF files are read natively as well, without the mesh cache: accessors are copied straight
+        // out of the mapped file, and embedded images only exist inside it
+        if (profile == ImportProfile_Fast && GltfFileReader::canRead(filePath)) {
+            auto parseStart = Clock::now();
+            if (GltfFileReader::read(filePath, model, listener)) {
+                auto texturesStart = Clock::now();
+                decodeTextures(model, filePath);
+                stats.nativeParser = true;
+                stats.parseMs = elapsedMs(parseStart, texturesStart);
+                stats.texturesMs = elapsedMs(texturesStart, Clock::now());
+                countGeometry(model);
+                std::cout << "ObjectReader: " << filePath << " [" << profileName << "] "
+                    << stats.vertices << " vertices, " << stats.indices << " indices, " << stats.meshes << " draw calls" << std::endl;
+                std::cout << "ObjectReader: " << filePath << " [" << profileName << "] (" << model.meshes.size() << " meshes)"
+                    << " native parse " << stats.parseMs << " ms, textures " << stats.texturesMs << " ms" << std::endl;
+                reportModel(model, listener);
+                return true;
+            }
+            if (listener && listener->isCancelled()) {
+                return false;
+            }
+            model = ModelData();
+        }
+
+        auto cacheStart = Clock::now();
+        if (MeshCache::load(filePath, profile, model)) {
+            auto texturesStart = Clock::now();
+            decodeTextures(model, filePath);
+            stats.fromCache = true;
+            stats.cacheMs = elapsedMs(cacheStart, texturesStart);
+            stats.texturesMs = elapsedMs(texturesStart, Clock::now());
+            countGeometry(model);
+            std::cout << "ObjectReader: " << filePath << " [" << profileName << "] (" << model.meshes.size() << " meshes)"
+                << " cache " << elapsedMs(cacheStart, texturesStart) << " ms,"
+                << " textures " << elapsedMs(texturesStart, Clock::now()) << " ms" << std::endl;
+            reportModel(model, listener);
+            return true;
+        }
+
+        // OBJ files are read natively. Profiles that need Assimp's post-processing, and files the
+        // native reader rejects, go through Assimp.
+        if (profile == ImportProfile_Fast && ObjFileReader::canRead(filePath)) {
+            auto parseStart = Clock::now();
+            if (ObjFileReader::read(filePath, model, listener)) {
+                auto texturesStart = Clock::now();
+                decodeTextures(model, filePath);
+                stats.nativeParser = true;
+                stats.parseMs = elapsedMs(parseStart, texturesStart);
+                stats.texturesMs = elapsedMs(texturesStart, Clock::now());
+                countGeometry(model);
+                std::cout << "ObjectReader: " << filePath << " [" << profileName << "] "
+                    << stats.vertices << " vertices, " << stats.indices << " indices, " << stats.meshes << " draw calls" << std::endl;
+                std::cout << "ObjectReader: " << filePath << " [" << profileName << "] (" << model.meshes.size() << " meshes)"
+                    << " native parse " << elapsedMs(parseStart, texturesStart) << " ms on " << pool.getConcurrency() << " threads,"
+                    << " textures " << elapsedMs(texturesStart, Clock::now()) << " ms" << std::endl;
+                MeshCache::save(filePath, profile, model);
+                reportModel(model, listener);
+                return true;
+            }
+            if (listener && listener->isCancelled()) {
+                return false;
+            }
+            model = ModelData();
+        }
+
+        // Parse stage: Assimp reads the file, then applies the profile (first half of the progress)
+        auto parseStart = Clock::now();
+        ParseProgressHandler progressHandler(*importer, listener);
+        const aiScene* scene = importer->ReadFile(filePath, IMPORT_BASE_FLAGS);
+        if (scene && scene->mRootNode && getImportProfileFlags(profile) != 0 && !(listener && listener->isCancelled())) {
+            SceneStats before = getSceneStats(scene);
+            auto postProcessStart = Clock::now();
+            scene = importer->ApplyPostProcessing(getImportProfileFlags(profile));
+            if (scene && scene->mRootNode) {
+                SceneStats after = getSceneStats(scene);
+                std::cout << "ObjectReader: " << filePath << " [" << profileName << "] "
+                    << before.vertices << " vertices, " << before.indices << " indices, " << before.drawCalls << " draw calls -> "
+                    << after.vertices << " vertices, " << after.indices << " indices, " << after.drawCalls << " draw calls"
+                    << " (post-process " << elapsedMs(postProcessStart, Clock::now()) << " ms)" << std::endl;
+            }
+        }
+        if (listener && listener->isCancelled()) {
+            return false;
+        }
 
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
             std::cerr << "Assimp error: " << importer->GetErrorString() << std::endl;
+            if (!scene || !scene->mRootNode) {
+                return false;
+            }
+        }
+        if (getImportProfileFlags(profile) == 0) {
+            SceneStats stats = getSceneStats(scene);
+            std::cout << "ObjectReader: " << filePath << " [" << profileName << "] "
+                << stats.vertices << " vertices, " << stats.indices << " indices, " << stats.drawCalls << " draw calls" << std::endl;
         }
 
-        std::vector<Mesh> meshes;
-        std::vector<Object3D*> objects;
+        // Materials and their textures are needed before any mesh can be shown
+        auto texturesStart = Clock::now();
+        for (unsigned int i = 0; i < scene->mNumMaterials; ++i) {
+            model.materials.push_back(readMaterial(scene->mMaterials[i]));
+        }
+        decodeTextures(model, filePath);
+        if (listener) {
+            listener->onMaterials(model);
+        }
 
-        processNode(scene->mRootNode, scene, meshes, filePath);
+        // CPU stage: convert every aiMesh on the thread pool (second half of the progress)
+        auto convertStart = Clock::now();
+        std::vector<const aiMesh*> sceneMeshes;
+        collectMeshes(scene->mRootNode, scene, sceneMeshes);
 
-        for (Mesh& mesh : meshes) {
-            Object3D* object = new Object3D(mesh);
-            objects.push_back(object);
+        model.meshes.resize(sceneMeshes.size());
+        const bool optimizeMeshes = isMeshOptimizedProfile(profile);
+        const bool buildMeshlets = isMeshletProfile(profile);
+        std::vector<VertexCacheStats> cacheBefore(optimizeMeshes ? sceneMeshes.size() : 0);
+        std::vector<VertexCacheStats> cacheAfter(cacheBefore.size());
+        std::atomic<size_t> converted(0);
+        pool.parallelFor(sceneMeshes.size(), [&](size_t i) {
+            if (listener && listener->isCancelled()) {
+                return;
+            }
+            model.meshes[i] = convertMesh(sceneMeshes[i]);
+            if (optimizeMeshes) {
+                MeshData& mesh = model.meshes[i];
+                cacheBefore[i] = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+                MeshOptimizer::optimize(mesh);
+                if (buildMeshlets) {
+                    MeshOptimizer::buildMeshlets(mesh);
+                }
+                cacheAfter[i] = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+                MeshOptimizer::generateLods(mesh);
+            }
+            if (listener) {
+                // the cache is written from model once every mesh is converted, so the listener
+                // gets its own copy, made here on the pool thread
+                listener->onMeshReady(MeshData(model.meshes[i]));
+                listener->onProgress(0.5f + 0.5f * static_cast<float>(++converted) / sceneMeshes.size());
+            }
+        });
+        auto convertEnd = Clock::now();
+        if (listener && listener->isCancelled()) {
+            return false;
         }
 
-        return objects;
+        stats.parseMs = elapsedMs(parseStart, texturesStart);
+        stats.texturesMs = elapsedMs(texturesStart, convertStart);
+        stats.convertMs = elapsedMs(convertStart, convertEnd);
+        countGeometry(model);
+        std::cout << "ObjectReader: " << filePath << " [" << profileName << "] (" << model.meshes.size() << " meshes)"
+            << " parse " << elapsedMs(parseStart, texturesStart) << " ms,"
+            << " textures " << elapsedMs(texturesStart, convertStart) << " ms,"
+            << " convert " << elapsedMs(convertStart, convertEnd) << " ms on " << pool.getConcurrency() << " threads" << std::endl;
+        if (optimizeMeshes) {
+            for (size_t i = 0; i < cacheBefore.size(); ++i) {
+                stats.cacheBefore.add(cacheBefore[i]);
+                stats.cacheAfter.add(cacheAfter[i]);
+            }
+            std::cout << "ObjectReader: " << filePath << " [" << profileName << "] vertex cache (" << MeshOptimizer::CACHE_SIZE << " entries)"
+                << " ACMR " << stats.cacheBefore.getACMR() << " -> " << stats.cacheAfter.getACMR() << ","
+                << " ATVR " << stats.cacheBefore.getATVR() << " -> " << stats.cacheAfter.getATVR() << std::endl;
+        }
+        if (buildMeshlets) {
+            std::cout << "ObjectReader: " << filePath << " [" << profileName << "] " << stats.meshlets << " meshlets, "
+                << (stats.meshlets > 0 ? stats.indices / 3 / stats.meshlets : 0) << " triangles on average" << std::endl;
+        }
+
+        MeshCache::save(filePath, profile, model);
+        if (listener) {
+            model.meshes = std::vector<MeshData>(model.meshes.size());
+        }
+        return true;
     }
 
-private:
-    Assimp::Importer* importer;
+    // Stage timings of the last loadModelData (and readModel) call
+    const ImportStats& getLastStats() {
+        return stats;
+    }
 
-    void processNode(const aiNode* node, const aiScene* scene, std::vector<Mesh>& meshes, const std::string& objPath) {
-        // Process all the meshes in this node
-        for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
-            const aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(createMesh(mesh, scene, objPath));
+    // Materials of a model with their textures created, indexed like ModelData::materials
+    typedef std::vector<std::shared_ptr<Material>> MaterialList;
+
+    /**
+     * Creates the materials of a model and their textures, once per material index.
+     * Meshes then share these instead of resolving the same material again.
+     * Must run on the thread that owns the GL context.
+     *
+     * @param model The converted model, with the images decoded during the import.
+     * @param filePath The path to the model file, texture paths are relative to it.
+     */
+    MaterialList createMaterials(const ModelData& model, const std::string& filePath) {
+        MaterialList materials;
+        materials.reserve(model.materials.size());
+        for (const Material& modelMaterial : model.materials) {
+            std::shared_ptr<Material> material = std::make_shared<Material>(modelMaterial);
+            loadMaterialTexture(*material, model, filePath);
+            materials.push_back(material);
         }
-        // Recursively process child nodes
-        for (unsigned int i = 0; i < node->mNumChildren; ++i) {
-            processNode(node->mChildren[i], scene, meshes, objPath);
+        return materials;
+    }
+
+    // Creates the scene object of a converted mesh. Must run on the thread that owns the GL context.
+    Object3D* createObject(const MeshData& meshData, const MaterialList& materials) {
+        return new Object3D(createMesh(meshData, materials));
+    }
+
+    /**
+     * Converts an aiMesh into plain vectors. Touches no GL state, so it runs on the worker threads.
+     *
+     * Every vector is sized once and each attribute stream is copied in its own branch-free loop
+     * (positions and normals share their layout with glm::vec3 and are copied as a block).
+     * The vectors are the staging buffers the GL stage uploads from.
+     */
+    static MeshData convertMesh(const aiMesh* mesh) {
+        static_assert(sizeof(aiVector3D) == sizeof(glm::vec3), "aiVector3D must match glm::vec3");
+
+        MeshData data;
+        data.name = mesh->mName.C_Str();
+        data.materialIndex = mesh->mMaterialIndex;
+        const size_t vertexCount = mesh->mNumVertices;
+
+        data.vertices.resize(vertexCount);
+        std::memcpy(data.vertices.data(), mesh->mVertices, vertexCount * sizeof(glm::vec3));
+
+        if (mesh->HasNormals()) {
+            data.normals.resize(vertexCount);
+            std::memcpy(data.normals.data(), mesh->mNormals, vertexCount * sizeof(glm::vec3));
+        } else {
+            data.normals.assign(vertexCount, glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+
+        if (mesh->HasTextureCoords(0)) {
+            data.texCoords.resize(vertexCount);
+            const aiVector3D* source = mesh->mTextureCoords[0];
+            glm::vec2* destination = data.texCoords.data();
+            for (size_t i = 0; i < vertexCount; ++i) {
+                destination[i] = glm::vec2(source[i].x, source[i].y);
+            }
+        }
+
+        // Triangulated meshes have exactly three indices per face, anything else takes the generic path
+        if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE) {
+            data.indices.resize(static_cast<size_t>(mesh->mNumFaces) * 3);
+            GLuint* destination = data.indices.data();
+            for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+                const unsigned int* face = mesh->mFaces[i].mIndices;
+                destination[3 * i] = face[0];
+                destination[3 * i + 1] = face[1];
+                destination[3 * i + 2] = face[2];
+            }
+        } else {
+            size_t indexCount = 0;
+            for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+                indexCount += mesh->mFaces[i].mNumIndices;
+            }
+            data.indices.resize(indexCount);
+            GLuint* destination = data.indices.data();
+            for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+                const aiFace& face = mesh->mFaces[i];
+                std::memcpy(destination, face.mIndices, face.mNumIndices * sizeof(GLuint));
+                destination += face.mNumIndices;
+            }
         }
+
+        return data;
     }
 
-    Mesh createMesh(const aiMesh* mesh, const aiScene* scene, const std::string& objPath) {
-        std::vector<glm::vec3> vertices;
-        std::vector<glm::vec2> textureCoords;
-        std::vector<glm::vec3> normals;
-        std::vector<GLuint> indices;
+private:
+    typedef std::chrono::steady_clock Clock;
 
-        for (unsigned int i = 0; i < mesh->mNumVertices; ++i) {
-            glm::vec3 auxVertex;
-            auxVertex.x = mesh->mVertices[i].x;
-            auxVertex.y = mesh->mVertices[i].y;
-            auxVertex.z = mesh->mVertices[i].z;
-            vertices.push_back(auxVertex);
+    Assimp::Importer* importer;
+    ImportStats stats;
 
-            if (mesh->HasTextureCoords(0)) {
-                glm::vec2 texCoord;
-                texCoord.x = mesh->mTextureCoords[0][i].x;
-                texCoord.y = mesh->mTextureCoords[0][i].y;
-                textureCoords.push_back(texCoord);
+    void countGeometry(const ModelData& model) {
+        stats.meshes = model.meshes.size();
+        for (const MeshData& meshData : model.meshes) {
+            stats.vertices += meshData.vertices.size();
+            stats.indices += meshData.indices.size();
+            stats.meshlets += meshData.meshlets.size();
+        }
+    }
+
+    // Forwards Assimp's parse progress to the listener and aborts the parse when it is cancelled.
+    // Reading and post-processing each report their own progress, it is kept from going backwards.
+    // Installed on the importer while it is in scope when there is a listener. The importer deletes
+    // the handler it holds when it is destroyed, so it is unset again on every way out of the scope.
+    class ParseProgressHandler : public Assimp::ProgressHandler {
+    public:
+        ParseProgressHandler(Assimp::Importer& importer, ImportListener* listener) : importer(importer), listener(listener), reported(0.0f) {
+            if (listener) {
+                importer.SetProgressHandler(this);
             }
+        }
 
-            if (mesh->HasNormals()) {
-                glm::vec3 normal;
-                normal.x = mesh->mNormals[i].x;
-                normal.y = mesh->mNormals[i].y;
-                normal.z = mesh->mNormals[i].z;
-                normals.push_back(normal);
-            } else {
-                normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+        ~ParseProgressHandler() {
+            if (listener) {
+                importer.SetProgressHandler(nullptr);
             }
         }
 
-        for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
-            const aiFace& face = mesh->mFaces[i];
-            for (unsigned int j = 0; j < face.mNumIndices; ++j) {
-                indices.push_back(face.mIndices[j]);
+        ParseProgressHandler(const ParseProgressHandler&) = delete;
+        ParseProgressHandler& operator=(const ParseProgressHandler&) = delete;
+
+        bool Update(float percentage) override {
+            if (percentage > reported) {
+                reported = percentage;
+                listener->onProgress(0.5f * percentage);
             }
+            return !listener->isCancelled();
         }
 
-        // Try to get mesh texture
-        if (mesh->mMaterialIndex >= 0 && mesh->mMaterialIndex < scene->mNumMaterials) {
-            Material material = createMaterial(scene->mMaterials[mesh->mMaterialIndex], objPath);
-            if (mesh->HasTextureCoords(0)){
-                return Mesh(vertices, textureCoords, normals, indices, material, mesh->mName.C_Str());
+    private:
+        Assimp::Importer& importer;
+        ImportListener* listener;
+        float reported;
+    };
+
+    // Geometry the viewer would create for a scene, one draw call per mesh reference in the hierarchy
+    struct SceneStats {
+        size_t vertices = 0;
+        size_t indices = 0;
+        size_t drawCalls = 0;
+    };
+
+    SceneStats getSceneStats(const aiScene* scene) {
+        SceneStats stats;
+        std::vector<const aiMesh*> meshes;
+        collectMeshes(scene->mRootNode, scene, meshes);
+        for (const aiMesh* mesh : meshes) {
+            stats.vertices += mesh->mNumVertices;
+            for (unsigned int i = 0; i < mesh->mNumFaces; ++i) {
+                stats.indices += mesh->mFaces[i].mNumIndices;
             }
-            return Mesh(vertices, normals, indices, material, mesh->mName.C_Str());
         }
+        stats.drawCalls = meshes.size();
+        return stats;
+    }
+
+    static double elapsedMs(Clock::time_point start, Clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
 
-        Material defaultMaterial;
-        return Mesh(vertices, normals, indices, defaultMaterial, mesh->mName.C_Str());
+    // Hands a model that was loaded in one go (cache or native reader) to the listener
+    static void reportModel(ModelData& model, ImportListener* listener) {
+        if (!listener) {
+            return;
+        }
+        listener->onMaterials(model);
+        for (MeshData& meshData : model.meshes) {
+            listener->onMeshReady(std::move(meshData));
+        }
+        listener->onProgress(1.0f);
+    }
+
+    // Decodes the textures used by the materials on the thread pool, skipping the ones already loaded
+    void decodeTextures(ModelData& model, const std::string& objPath) {
+        std::vector<std::string> texturePaths;
+        for (const Material& material : model.materials) {
+            if (!material.texturePath.empty() && model.images.find(material.texturePath) == model.images.end()
+                && !ResourceManager::hasTexture(getTextureName(objPath, material.texturePath))) {
+                model.images[material.texturePath] = ImageData();
+                texturePaths.push_back(material.texturePath);
+            }
+        }
+        ThreadPool::shared().parallelFor(texturePaths.size(), [&](size_t i) {
+            std::string file = relativizePath(objPath, texturePaths[i]);
+            model.images.find(texturePaths[i])->second = ResourceManager::decodeImage(file.c_str());
+        });
+    }
+
+    // Lists the meshes referenced by the node hierarchy, in the same order they were always processed
+    void collectMeshes(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes) {
+        for (unsigned int i = 0; i < node->mNumMeshes; ++i) {
+            meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+        }
+        // Recursively process child nodes
+        for (unsigned int i = 0; i < node->mNumChildren; ++i) {
+            collectMeshes(node->mChildren[i], scene, meshes);
+        }
+    }
+
+    // Creates the GL mesh for converted data. Must run on the thread that owns the GL context.
+    Mesh createMesh(const MeshData& data, const MaterialList& materials) {
+        // Meshes using the same material index share one material
+        if (data.materialIndex < materials.size()) {
+            return Mesh(data, materials[data.materialIndex]);
+        }
+
+        return Mesh(data, std::make_shared<Material>());
+    }
+
+    // Creates the texture referenced by a material, from the decoded image when there is one
+    void loadMaterialTexture(Material& material, const ModelData& model, const std::string& objPath) {
+        if (material.texturePath.empty()) {
+            return;
+        }
+        std::string textureName = getTextureName(objPath, material.texturePath);
+        auto image = model.images.find(material.texturePath);
+        if (image != model.images.end()) {
+            material.texture = &ResourceManager::loadTexture(image->second, textureName);
+        } else {
+            std::string meshTexturePath = relativizePath(objPath, material.texturePath);
+            material.texture = &ResourceManager::loadTexture(meshTexturePath.c_str(), textureName);
+        }
+    }
+
+    // Name of a material texture in the ResourceManager. Embedded textures ("*0", "*1"...) are only
+    // unique within their model file, so they are prefixed with it.
+    static std::string getTextureName(const std::string& objPath, const std::string& texturePath) {
+        if (!texturePath.empty() && texturePath[0] == '*') {
+            return objPath + texturePath;
+        }
+        return texturePath;
     }
 
-    Material createMaterial(const aiMaterial* material, const std::string& objPath) {
+    // Reads the material properties and texture path. The texture itself is loaded by the GL stage.
+    static Material readMaterial(const aiMaterial* material) {
         Material mat;
 
         // Try to get material texture
@@ -128,9 +545,7 @@ private:
                 if (material->GetTexture(textureType, j, &texturePath) == AI_SUCCESS) {
                     std::string texturePathStr = texturePath.C_Str();
                     if (!texturePathStr.empty()) {
-                        std::string meshTexturePath = relativizePath(objPath, texturePathStr).c_str();
-                        Texture2D meshTexture = ResourceManager::loadTexture(meshTexturePath.c_str(), texturePathStr);
-                        mat.texture = meshTexture;
+                        mat.texturePath = texturePathStr;
                     }
                 }
             }
@@ -167,7 +582,7 @@ private:
         return mat;
     }
 
-    std::string relativizePath(const std::string& basePath, const std::string& relativePath) {
+    static std::string relativizePath(const std::string& basePath, const std::string& relativePath) {
         fs::path base(basePath);
         fs::path relative(relativePath);
         if (fs::is_regular_file(base)) {
@@ -2,6 +2,7 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <utility>
 #include <vector>
 
 #include "effects.h"
@@ -26,22 +27,23 @@ public:
             int screenWidth, screenHeight;
             glfwGetWindowSize(glfwGetCurrentContext(), &screenWidth, &screenHeight);
 
-            initialFrameBuffer = ResourceManager::loadFrameBuffer(screenWidth, screenHeight, "initialFrameBuffer");
-            initialFrameBuffer.bind();
+            initialFrameBuffer = &ResourceManager::loadFrameBuffer(screenWidth, screenHeight, "initialFrameBuffer");
+            initialFrameBuffer->bind();
             glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         }
     }
 
     void end() {
-        applyPipeline(initialFrameBuffer, FrameBuffer::getDefault());
+        FrameBuffer defaultFrameBuffer = FrameBuffer::getDefault();
+        applyPipeline(*initialFrameBuffer, defaultFrameBuffer);
     }
 
 private:
-    FrameBuffer initialFrameBuffer;
+    FrameBuffer* initialFrameBuffer = nullptr; // owned by ResourceManager
     std::vector<Effect*> effects;
 
-    void applyPipeline(FrameBuffer& inputFramebuffer, FrameBuffer outputFramebuffer) {
+    void applyPipeline(FrameBuffer& inputFramebuffer, FrameBuffer& outputFramebuffer) {
         if (effects.empty()) {
             return;
         }
@@ -51,25 +53,17 @@ private:
             return;
         }
 
-        FrameBuffer intermediateFramebufferA = ResourceManager::loadFrameBuffer(outputFramebuffer.width, outputFramebuffer.height, "intermediateFramebufferA");
-        effects[0]->apply(inputFramebuffer, intermediateFramebufferA);
-        if (effects.size() == 2) {
-            effects[1]->apply(intermediateFramebufferA, outputFramebuffer);
-            return;
-        }
-
-        FrameBuffer intermediateFramebufferB = ResourceManager::loadFrameBuffer(outputFramebuffer.width, outputFramebuffer.height, "intermediateFramebufferB");
-        effects[1]->apply(intermediateFramebufferA, intermediateFramebufferB);
-        if (effects.size() == 3) {
-            effects[2]->apply(intermediateFramebufferB, outputFramebuffer);
-            return;
-        }
-
-        for (int i = 3; i < effects.size() - 1; i++) {
-            effects[i]->apply(intermediateFramebufferB, intermediateFramebufferA);
-            intermediateFramebufferB = intermediateFramebufferA;
+        // Effects in between ping-pong between two intermediate framebuffers
+        FrameBuffer* input = &ResourceManager::loadFrameBuffer(outputFramebuffer.width, outputFramebuffer.height, "intermediateFramebufferA");
+        effects[0]->apply(inputFramebuffer, *input);
+        if (effects.size() > 2) {
+            FrameBuffer* output = &ResourceManager::loadFrameBuffer(outputFramebuffer.width, outputFramebuffer.height, "intermediateFramebufferB");
+            for (size_t i = 1; i < effects.size() - 1; i++) {
+                effects[i]->apply(*input, *output);
+                std::swap(input, output);
+            }
         }
 
-        effects[effects.size() - 1]->apply(intermediateFramebufferA, outputFramebuffer);
+        effects[effects.size() - 1]->apply(*input, outputFramebuffer);
     }
-};
\ No newline at end of file
+};
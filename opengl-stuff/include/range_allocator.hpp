@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+
+// First-fit allocator of ranges inside a buffer of fixed capacity, in whatever unit the caller
+// uses (vertices, indices). Free ranges are kept sorted by offset and merged with their
+// neighbours when released, so freeing everything gives back a single range.
+class RangeAllocator {
+public:
+    RangeAllocator() : capacity(0), freeSize(0) { }
+
+    explicit RangeAllocator(size_t capacity) : capacity(0), freeSize(0) {
+        reset(capacity);
+    }
+
+    // Forgets every allocation, the whole capacity becomes one free range
+    void reset(size_t capacity) {
+        this->capacity = capacity;
+        freeRanges.clear();
+        freeSize = capacity;
+        if (capacity > 0) {
+            freeRanges[0] = capacity;
+        }
+    }
+
+    /**
+     * Takes the first free range large enough.
+     *
+     * @param size Size of the range, 0 always succeeds with offset 0.
+     * @param offset Receives the start of the range.
+     * @return false if no free range is large enough.
+     */
+    bool allocate(size_t size, size_t& offset) {
+        if (size == 0) {
+            offset = 0;
+            return true;
+        }
+        for (auto range = freeRanges.begin(); range != freeRanges.end(); ++range) {
+            if (range->second < size) {
+                continue;
+            }
+            offset = range->first;
+            size_t remaining = range->second - size;
+            freeRanges.erase(range);
+            if (remaining > 0) {
+                freeRanges[offset + size] = remaining;
+            }
+            freeSize -= size;
+            return true;
+        }
+        return false;
+    }
+
+    // Gives a range back, merging it with the free ranges right before and after it
+    void release(size_t offset, size_t size) {
+        if (size == 0) {
+            return;
+        }
+        freeSize += size;
+        auto next = freeRanges.lower_bound(offset);
+        if (next != freeRanges.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset) {
+                offset = previous->first;
+                size += previous->second;
+                freeRanges.erase(previous);
+            }
+        }
+        if (next != freeRanges.end() && offset + size == next->first) {
+            size += next->second;
+            freeRanges.erase(next);
+        }
+        freeRanges[offset] = size;
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+
+    size_t getFreeSize() const {
+        return freeSize;
+    }
+
+    size_t getUsedSize() const {
+        return capacity - freeSize;
+    }
+
+    // Number of separate free ranges, more than one means the free space is fragmented
+    size_t getFreeRangeCount() const {
+        return freeRanges.size();
+    }
+
+private:
+    size_t capacity;
+    size_t freeSize;
+    std::map<size_t, size_t> freeRanges; // offset -> size
+};
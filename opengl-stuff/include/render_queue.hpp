@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "index_packing.hpp"
+#include "object_3d.hpp"
+#include "texture.h"
+
+// Groups of draws, submitted in this order
+enum RenderPass_
+{
+    RenderPass_Opaque,
+    RenderPass_Transparent, // blended over the opaque ones, far to near
+    RenderPass_Wireframe,   // outline of the selected objects, over everything else
+    RenderPass_Count
+};
+typedef int RenderPass;
+
+// One draw of an object, recorded by Renderer::submit() and drawn by Renderer::flush()
+struct RenderItem {
+    uint64_t key;
+    Object3D* object;
+    glm::mat4 model;
+    Texture2D* texture;
+    bool blend;
+    bool wireframe;
+    // with meshletsCulled, only a range of RenderQueue::getMeshletRanges() is drawn instead of the current LOD
+    bool meshletsCulled;
+    size_t firstMeshletRange;
+    size_t meshletRangeCount;
+};
+
+// Draws of a frame, collected in any order and sorted by a 64-bit key so the ones sharing GL state
+// end up next to each other. From the most to the least significant bits the key holds:
+//  - pass (2 bits) and blending (1 bit)
+//  - depth (16 bits), far to near, only in the transparent pass where order matters more than state
+//  - shader program (8 bits), texture (16 bits), vertex layout (6 bits), geometry (13 bits) and LOD (2 bits)
+// Ids wider than their field are truncated, which only makes the batching less tight. Copies of a
+// model get the same key, so they end up next to each other and are drawn as instances of one draw.
+class RenderQueue {
+public:
+    static uint64_t makeKey(RenderPass pass, bool blend, float depth, GLuint program, GLuint texture, size_t layout, size_t geometry, size_t lod) {
+        uint64_t depthBits = 0;
+        if (pass == RenderPass_Transparent) {
+            depthBits = 0xFFFF - static_cast<uint64_t>(glm::clamp(depth, 0.0f, 1.0f) * 0xFFFF);
+        }
+        return static_cast<uint64_t>(pass) << 62
+            | static_cast<uint64_t>(blend ? 1 : 0) << 61
+            | depthBits << 45
+            | static_cast<uint64_t>(program & 0xFF) << 37
+            | static_cast<uint64_t>(texture & 0xFFFF) << 21
+            | static_cast<uint64_t>(layout & 0x3F) << 15
+            | static_cast<uint64_t>(geometry & 0x1FFF) << 2
+            | static_cast<uint64_t>(std::min<size_t>(lod, 3));
+    }
+
+    void clear() {
+        items.clear();
+        meshletRanges.clear();
+    }
+
+    void push(const RenderItem& item) {
+        items.push_back(item);
+    }
+
+    // Stable, so draws with the same key keep the order they were submitted in
+    void sort() {
+        std::stable_sort(items.begin(), items.end(), [](const RenderItem& a, const RenderItem& b) {
+            return a.key < b.key;
+        });
+    }
+
+    const std::vector<RenderItem>& getItems() const {
+        return items;
+    }
+
+    // Index ranges (baseVertex unused) of the visible meshlets of every item, see RenderItem
+    std::vector<IndexPart>& getMeshletRanges() {
+        return meshletRanges;
+    }
+
+private:
+    std::vector<RenderItem> items;
+    std::vector<IndexPart> meshletRanges;
+};
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
 #include <glm/glm.hpp>
 
 #include "camera.hpp"
+#include "frustum_culling.h"
+#include "gl_state.h"
 #include "light.hpp"
 #include "object_3d.hpp"
+#include "render_queue.hpp"
 #include "resource_manager.h"
 #include "shader.h"
+#include "stream_buffer.h"
 
 enum RenderModes_
 {
@@ -16,80 +24,376 @@ enum RenderModes_
 
 typedef int RenderModes;
 
+// Screen size (bounding sphere diameter over the viewport height) below which LOD 1, 2 and 3 are drawn
+const float LOD_SCREEN_SIZES[] = { 0.5f, 0.25f, 0.125f };
+const size_t LOD_SCREEN_SIZE_COUNT = sizeof(LOD_SCREEN_SIZES) / sizeof(LOD_SCREEN_SIZES[0]);
+// How far past a threshold the size has to go before the level changes, so objects sitting on a
+// threshold do not flicker between two levels
+const float LOD_HYSTERESIS = 0.1f;
+
 class Renderer {
 public:
     Camera* camera;
     Light* light;
+    // picks each object's LOD level from its size on screen, full resolution otherwise
+    bool automaticLod = true;
+    // skips the objects whose bounds are outside the view frustum
+    bool frustumCulling = true;
+    // skips the meshlets of full resolution meshes that are off screen or, for closed opaque meshes, face away
+    bool meshletCulling = true;
+    // objects tested by cullObjects() in the last frame, and how many of them were outside the frustum
+    size_t objectCount = 0;
+    size_t culledObjectCount = 0;
+    // meshlets tested by the culling since the last resetStats(), and how many of them were skipped
+    size_t meshletCount = 0;
+    size_t culledMeshletCount = 0;
+    // draw calls issued and objects they drew since the last resetStats(), GLState counts the state changes
+    size_t drawCallCount = 0;
+    size_t instanceCount = 0;
 
     Renderer(glm::vec2 dimensions, Camera& camera, Light& light) {
         this->screenDimensions = dimensions;
         this->camera = &camera;
         this->light = &light;
         this->shader = ResourceManager::loadShader("assets/shaders/default.vs", "assets/shaders/default.fs", nullptr, "defaultShader");
-        this->wireframeTexture = ResourceManager::loadTexture(glm::vec4(0.0f, 1.0f, 1.0f, 1.0f), "wireframeTexture");
-        this->defaultTexture = ResourceManager::loadTexture(glm::vec4(0.7f, 0.7f, 0.7f, 1.0f), "defaultTexture");
+        this->wireframeTexture = &ResourceManager::loadTexture(glm::vec4(0.0f, 1.0f, 1.0f, 1.0f), "wireframeTexture");
+        this->defaultTexture = &ResourceManager::loadTexture(glm::vec4(0.7f, 0.7f, 0.7f, 1.0f), "defaultTexture");
 
         shader.use();
         shader.setInteger("texBuff", 0);
-        glActiveTexture(GL_TEXTURE0);
+        GLState::activeTexture(0);
+        loadUniformLocations();
+
+        glGenBuffers(1, &frameUniformBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, frameUniformBuffer);
+        shader.bindUniformBlock("FrameUniforms", FRAME_UNIFORMS_BINDING);
+    }
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    // deletes the frame uniform buffer, must be called while the context exists
+    void release() {
+        glDeleteBuffers(1, &frameUniformBuffer);
+        frameUniformBuffer = 0;
     }
 
-    void render(Object3D& object, RenderModes renderModes = RenderModes_Normal) {
-        // Calculate projection
-        glm::mat4 projection = glm::perspective(glm::radians(camera->cameraZoom), (float)screenDimensions.x / (float)screenDimensions.y, 0.1f, 500.0f);
-        // Calculate light position in world space
-        // Necessary to calculate light position in world space because the object is translated and rotated
+    void resetStats() {
+        objectCount = 0;
+        culledObjectCount = 0;
+        meshletCount = 0;
+        culledMeshletCount = 0;
+        drawCallCount = 0;
+        instanceCount = 0;
+    }
+
+    // Uploads the camera and light of the frame, once per frame before the first submit()
+    void beginFrame() {
+        resetStats();
+        frame.projection = glm::perspective(glm::radians(camera->cameraZoom), (float)screenDimensions.x / (float)screenDimensions.y, 0.1f, FAR_PLANE);
+        frame.view = camera->getViewMatrix();
+        frame.viewProjection = frame.projection * frame.view;
+        frame.viewPos = glm::vec4(camera->position, 1.0f);
+        frame.lightPosition = glm::vec4(light->position, 1.0f);
+        frame.lightAmbient = glm::vec4(light->color * light->ambientStrength, 0.0f);
+        frame.lightDiffuse = glm::vec4(light->color * light->diffuseStrength, 0.0f);
+        frame.lightSpecular = glm::vec4(light->color * light->specularStrength, 0.0f);
+
+        glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // Tests the bounds of all objects against the view frustum at once, after beginFrame(). The
+    // result is read with isVisible(), by index into objects.
+    void cullObjects(const std::vector<Object3D*>& objects) {
+        objectCount = objects.size();
+        if (!frustumCulling) {
+            visibleObjects.assign(objects.size(), 1);
+            culledObjectCount = 0;
+            return;
+        }
+        cullingBounds.clear();
+        for (Object3D* object : objects) {
+            Mesh& mesh = object->mesh;
+            cullingBounds.add(object->getModelMatrix(), mesh.getBoundsCenter(), mesh.getBoundsRadius(), mesh.getBoundsExtent());
+        }
+        glm::vec4 planes[6];
+        FrustumCulling::extractPlanes(frame.viewProjection, planes);
+        culledObjectCount = objects.size() - FrustumCulling::cull(planes, cullingBounds, visibleObjects);
+    }
+
+    // Whether the object at index of the last cullObjects() call may be on screen
+    bool isVisible(size_t index) {
+        return index >= visibleObjects.size() || visibleObjects[index] != 0;
+    }
+
+    // Queues the draws of an object for flush(): picks its LOD level and culls its meshlets
+    void submit(Object3D& object, RenderModes renderModes = RenderModes_Normal) {
         glm::mat4 model = object.getModelMatrix();
-        glm::mat4 inverseModel = glm::inverse(model);
-        glm::vec4 lightPositionWorldSpace = inverseModel * glm::vec4(light->position, 1.0);
-        // Setup shader
-        shader.use();
-        shader.setMatrix4("projection", projection);
-        shader.setMatrix4("view", camera->getViewMatrix());
-        shader.setMatrix4("model", model);
-        shader.setVector3f("light.position", glm::vec3(lightPositionWorldSpace));
-        shader.setVector3f("light.ambient", light->color * light->ambientStrength);
-        shader.setVector3f("light.diffuse", light->color * light->diffuseStrength);
-        shader.setVector3f("light.specular", light->color * light->specularStrength);
-        shader.setVector3f("viewPos", camera->position);
-
-        Material material = object.mesh.getMaterial();
-        shader.setVector3f("material.ambient", material.ambientColor);
-        shader.setVector3f("material.diffuse", material.diffuseColor);
-        shader.setVector3f("material.specular", material.specularColor);
-        shader.setVector3f("material.emissive", material.emissiveColor);
-        shader.setFloat("material.shininess", material.shininess);
-        shader.setFloat("material.opacity", material.opacity);
-
-        // Bind mesh attribute array
-        object.mesh.bind();
-        // Normal render
+        Mesh& mesh = object.mesh;
+        mesh.setLod(automaticLod ? selectLod(mesh, model) : 0);
+        const Material& material = mesh.getMaterial();
+
+        // Back faces are drawn, so back-facing meshlets are only hidden anyway on closed opaque meshes
+        std::vector<IndexPart>& meshletRanges = queue.getMeshletRanges();
+        size_t firstMeshletRange = meshletRanges.size();
+        bool meshletsCulled = meshletCulling && mesh.getLod() == 0 && !mesh.getMeshlets().empty()
+            && cullMeshlets(mesh, frame.viewProjection * model, glm::vec3(glm::inverse(model) * frame.viewPos),
+                material.opacity >= 1.0f && mesh.isClosed(), meshletRanges);
+        size_t meshletRangeCount = meshletRanges.size() - firstMeshletRange;
+        if (meshletsCulled && meshletRangeCount == 0) {
+            return;
+        }
+
+        const GLuint program = shader.ID;
+        const size_t layout = mesh.getPool();
+        const size_t geometry = mesh.getGeometryId();
         if (renderModes & RenderModes_Normal) {
-            // If has texture
-            if (material.texture.id != 0) {
-                material.texture.bind();
-            } else {
-                defaultTexture.bind();
+            Texture2D* texture = material.texture != nullptr ? material.texture : defaultTexture;
+            bool transparent = material.opacity < 1.0f;
+            // Textures without an alpha channel draw the same with blending off
+            bool blend = transparent || texture->internalFormat == GL_RGBA;
+            RenderPass pass = transparent ? RenderPass_Transparent : RenderPass_Opaque;
+            float depth = 0.0f;
+            if (transparent) {
+                depth = glm::length(glm::vec3(model * glm::vec4(mesh.getBoundsCenter(), 1.0f)) - camera->position) / FAR_PLANE;
             }
-            // Config blending
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glDrawElements(GL_TRIANGLES, object.mesh.getVertexCount(), GL_UNSIGNED_INT, 0);
+            queue.push({ RenderQueue::makeKey(pass, blend, depth, program, texture->id, layout, geometry, mesh.getLod()), &object, model, texture,
+                blend, false, meshletsCulled, firstMeshletRange, meshletRangeCount });
         }
-        // Wireframe render
         if (renderModes & RenderModes_Wireframe) {
-            wireframeTexture.bind();
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-            glDrawElements(GL_TRIANGLES, object.mesh.getVertexCount(), GL_UNSIGNED_INT, 0);
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            queue.push({ RenderQueue::makeKey(RenderPass_Wireframe, false, 0.0f, program, wireframeTexture->id, layout, geometry, mesh.getLod()), &object, model,
+                wireframeTexture, false, true, meshletsCulled, firstMeshletRange, meshletRangeCount });
+        }
+    }
+
+    // Draws the queued items in key order and empties the queue. Consecutive items of the same
+    // geometry, LOD and material become one instanced draw, their model matrices are streamed once
+    // for the whole queue. Items of the same state follow each other, so GLState drops most binds,
+    // and the uniforms already set for a geometry or material are skipped too.
+    void flush() {
+        queue.sort();
+        const std::vector<RenderItem>& items = queue.getItems();
+        if (items.empty()) {
+            return;
+        }
+        instances.clear();
+        for (const RenderItem& item : items) {
+            instances.push_back({ item.model, getNormalMatrix(item.model) });
+        }
+        size_t instancesOffset = StreamBuffer::upload(instances.data(), instances.size() * sizeof(InstanceAttributes), sizeof(glm::vec4));
+        GLuint instanceBuffer = StreamBuffer::getBuffer();
+
+        shader.use();
+        GLState::activeTexture(0);
+        GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        const Material* boundMaterial = nullptr;
+        GeometryArena::AllocationId boundGeometry = SIZE_MAX;
+
+        for (size_t first = 0; first < items.size(); ) {
+            const RenderItem& item = items[first];
+            size_t end = first + 1;
+            while (end < items.size() && canInstance(item, items[end])) {
+                ++end;
+            }
+
+            Mesh& mesh = item.object->mesh;
+            item.texture->bind();
+            mesh.bind();
+            GeometryArena::bindInstances(instanceBuffer, instancesOffset + first * sizeof(InstanceAttributes));
+            GLState::setBlend(item.blend);
+            GLState::polygonMode(item.wireframe ? GL_LINE : GL_FILL);
+
+            // Per-geometry and per-material uniforms, the camera and light come from the frame uniform buffer
+            if (mesh.getGeometryId() != boundGeometry) {
+                shader.setVector3f(uniforms.positionScale, mesh.getPositionScale());
+                shader.setVector3f(uniforms.positionOffset, mesh.getPositionOffset());
+                shader.setInteger(uniforms.octahedralNormals, mesh.getVertexFormat() == VertexFormat_Compressed);
+                boundGeometry = mesh.getGeometryId();
+            }
+            const Material& material = mesh.getMaterial();
+            if (&material != boundMaterial) {
+                shader.setVector3f(uniforms.materialAmbient, material.ambientColor);
+                shader.setVector3f(uniforms.materialDiffuse, material.diffuseColor);
+                shader.setVector3f(uniforms.materialSpecular, material.specularColor);
+                shader.setVector3f(uniforms.materialEmissive, material.emissiveColor);
+                shader.setFloat(uniforms.materialShininess, material.shininess);
+                shader.setFloat(uniforms.materialOpacity, material.opacity);
+                boundMaterial = &material;
+            }
+            drawItem(item, end - first);
+            instanceCount += end - first;
+            first = end;
         }
-        // Unbind
-        glBindVertexArray(0);
+        GLState::polygonMode(GL_FILL);
+        queue.clear();
     }
 
 private:
+    static constexpr float FAR_PLANE = 500.0f;
+    // Uniform buffer binding point of FrameUniforms
+    static const GLuint FRAME_UNIFORMS_BINDING = 0;
+
+    // Per-frame data of default.vs and default.fs, in the std140 layout of their FrameUniforms block.
+    // Only vec4 and mat4 members, so the C++ layout has no padding to keep in sync.
+    struct FrameUniforms {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;
+        glm::vec4 viewPos;       // w = 1
+        glm::vec4 lightPosition; // world space, w = 1
+        glm::vec4 lightAmbient;
+        glm::vec4 lightDiffuse;
+        glm::vec4 lightSpecular;
+    };
+    static_assert(sizeof(FrameUniforms) == 3 * 64 + 5 * 16, "FrameUniforms must match the std140 block");
+
+    // Locations of the uniforms set per geometry and material, looked up once
+    struct Uniforms {
+        GLint positionScale, positionOffset, octahedralNormals;
+        GLint materialAmbient, materialDiffuse, materialSpecular, materialEmissive, materialShininess, materialOpacity;
+    };
+
+    void loadUniformLocations() {
+        uniforms.positionScale = shader.getUniformLocation("positionScale");
+        uniforms.positionOffset = shader.getUniformLocation("positionOffset");
+        uniforms.octahedralNormals = shader.getUniformLocation("octahedralNormals");
+        uniforms.materialAmbient = shader.getUniformLocation("material.ambient");
+        uniforms.materialDiffuse = shader.getUniformLocation("material.diffuse");
+        uniforms.materialSpecular = shader.getUniformLocation("material.specular");
+        uniforms.materialEmissive = shader.getUniformLocation("material.emissive");
+        uniforms.materialShininess = shader.getUniformLocation("material.shininess");
+        uniforms.materialOpacity = shader.getUniformLocation("material.opacity");
+    }
+
+    // Coarser levels once the size clearly dropped below their threshold, finer ones once it clearly
+    // grew above the threshold of the current level
+    size_t selectLod(Mesh& mesh, const glm::mat4& model) {
+        glm::vec3 center = glm::vec3(model * glm::vec4(mesh.getBoundsCenter(), 1.0f));
+        float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        float radius = mesh.getBoundsRadius() * scale;
+        float distance = glm::length(center - camera->position);
+        if (distance <= radius) {
+            return 0;
+        }
+        float screenSize = radius / (distance * std::tan(glm::radians(camera->cameraZoom) * 0.5f));
+
+        size_t lodCount = std::min(mesh.getLodCount(), LOD_SCREEN_SIZE_COUNT + 1);
+        size_t lod = std::min(mesh.getLod(), lodCount - 1);
+        while (lod + 1 < lodCount && screenSize < LOD_SCREEN_SIZES[lod] * (1.0f - LOD_HYSTERESIS)) {
+            ++lod;
+        }
+        while (lod > 0 && screenSize > LOD_SCREEN_SIZES[lod - 1] * (1.0f + LOD_HYSTERESIS)) {
+            --lod;
+        }
+        return lod;
+    }
+
+    // Appends to ranges the index ranges of the meshlets that intersect the view frustum and, with
+    // cullBackFacing, do not face away from the eye (in object space). Returns false when the mesh
+    // has no meshlets or all of them are visible, it is drawn at once then.
+    bool cullMeshlets(Mesh& mesh, const glm::mat4& modelViewProjection, const glm::vec3& eye, bool cullBackFacing, std::vector<IndexPart>& ranges) {
+        const std::vector<Meshlet>& meshlets = mesh.getMeshlets();
+        if (meshlets.empty()) {
+            return false;
+        }
+        // Frustum planes in object space (Gribb and Hartmann), normalized so distances are in object units
+        glm::mat4 rows = glm::transpose(modelViewProjection);
+        glm::vec4 planes[6] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2] };
+        for (glm::vec4& plane : planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        const size_t firstRange = ranges.size();
+        size_t culled = 0;
+        for (const Meshlet& meshlet : meshlets) {
+            bool visible = true;
+            for (const glm::vec4& plane : planes) {
+                if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius) {
+                    visible = false;
+                    break;
+                }
+            }
+            if (visible && cullBackFacing) {
+                glm::vec3 view = meshlet.center - eye;
+                visible = glm::dot(view, meshlet.coneAxis) < meshlet.coneCutoff * glm::length(view) + meshlet.radius;
+            }
+            if (!visible) {
+                ++culled;
+                continue;
+            }
+            // Meshlets are stored back to back, neighbours in the index list are drawn together
+            if (ranges.size() > firstRange && ranges.back().firstIndex + ranges.back().indexCount == meshlet.firstIndex) {
+                ranges.back().indexCount += meshlet.indexCount;
+            } else {
+                ranges.push_back({ meshlet.firstIndex, meshlet.indexCount, 0 });
+            }
+        }
+        meshletCount += meshlets.size();
+        culledMeshletCount += culled;
+        if (culled == 0) {
+            ranges.resize(firstRange);
+        }
+        return culled > 0;
+    }
+
+    // Rotations with a uniform scale keep their own upper 3x3, the shader normalizes the normals
+    // anyway. Other transforms take the inverse transpose.
+    static glm::mat3 getNormalMatrix(const glm::mat4& model) {
+        glm::mat3 linear(model);
+        float lengthX = glm::dot(linear[0], linear[0]);
+        float lengthY = glm::dot(linear[1], linear[1]);
+        float lengthZ = glm::dot(linear[2], linear[2]);
+        float tolerance = 1e-4f * std::max(lengthX, std::max(lengthY, lengthZ));
+        bool uniformScale = std::abs(lengthX - lengthY) <= tolerance && std::abs(lengthX - lengthZ) <= tolerance
+            && std::abs(glm::dot(linear[0], linear[1])) <= tolerance && std::abs(glm::dot(linear[0], linear[2])) <= tolerance
+            && std::abs(glm::dot(linear[1], linear[2])) <= tolerance;
+        return uniformScale ? linear : glm::transpose(glm::inverse(linear));
+    }
+
+    // Whether b can be drawn as another instance of a: same state, geometry, LOD and material. Items
+    // whose meshlets were culled draw their own index ranges, so they are never instanced.
+    bool canInstance(const RenderItem& a, const RenderItem& b) {
+        if (a.key != b.key || a.meshletsCulled || b.meshletsCulled || a.texture != b.texture) {
+            return false;
+        }
+        Mesh& meshA = a.object->mesh;
+        Mesh& meshB = b.object->mesh;
+        return meshA.getGeometryId() == meshB.getGeometryId() && meshA.getLod() == meshB.getLod()
+            && meshA.getMaterial().looksLike(meshB.getMaterial());
+    }
+
+    void drawItem(const RenderItem& item, size_t instances) {
+        Mesh& mesh = item.object->mesh;
+        if (!item.meshletsCulled) {
+            mesh.draw(instances);
+            ++drawCallCount;
+            return;
+        }
+        const std::vector<IndexPart>& ranges = queue.getMeshletRanges();
+        for (size_t i = item.firstMeshletRange; i < item.firstMeshletRange + item.meshletRangeCount; ++i) {
+            mesh.drawRange(ranges[i].firstIndex, ranges[i].indexCount);
+        }
+        drawCallCount += item.meshletRangeCount;
+    }
+
     Shader shader;
-    Texture2D wireframeTexture;
-    Texture2D defaultTexture;
+    Uniforms uniforms;
+    FrameUniforms frame;
+    GLuint frameUniformBuffer = 0;
+    // owned by ResourceManager
+    Texture2D* wireframeTexture;
+    Texture2D* defaultTexture;
     glm::vec2 screenDimensions;
+    // draws submitted since the last flush()
+    RenderQueue queue;
+    // model and normal matrices of the queued items in drawing order, streamed as instance attributes
+    std::vector<InstanceAttributes> instances;
+    // world bounds of the objects of the last cullObjects() call and whether each one is visible
+    CullingBounds cullingBounds;
+    std::vector<uint8_t> visibleObjects;
 };
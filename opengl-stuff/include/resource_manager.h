@@ -1,6 +1,7 @@
 #pragma once
 
 #include <map>
+#include <mutex>
 #include <string>
 
 #include <glad/glad.h>
@@ -14,23 +15,33 @@
 // and/or shader is also stored for future reference by string
 // handles. All functions and resources are static and no 
 // public constructor is defined.
+// Frame buffers and textures own their GL objects and cannot be copied: the manager keeps them and
+// hands out references, which stay valid until clear(). clear() must run while the GL context exists.
 class ResourceManager
 {
 public:
     // loads (and generates) a frame buffer
-    static FrameBuffer loadFrameBuffer(unsigned int width, unsigned int height, std::string name);
+    static FrameBuffer& loadFrameBuffer(unsigned int width, unsigned int height, std::string name);
     // retrieves a stored frame buffer
-    static FrameBuffer getFrameBuffer(std::string name);
+    static FrameBuffer& getFrameBuffer(std::string name);
     // loads (and generates) a shader program from file loading vertex, fragment (and geometry) shader's source code. If gShaderFile is not nullptr, it also loads a geometry shader
     static Shader    loadShader(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile, std::string name);
     // retrieves a stored sader
     static Shader    getShader(std::string name);
     // loads (and generates) a texture from file
-    static Texture2D loadTexture(const char* file, std::string name);
+    static Texture2D& loadTexture(const char* file, std::string name);
+    // loads (and generates) a texture from already decoded pixels
+    static Texture2D& loadTexture(const ImageData& image, std::string name);
     // loads (and generates) a texture from color
-    static Texture2D loadTexture(const glm::vec4 color, std::string name);
+    static Texture2D& loadTexture(const glm::vec4 color, std::string name);
     // retrieves a stored texture
-    static Texture2D getTexture(std::string name);
+    static Texture2D& getTexture(std::string name);
+    // checks if a texture is already stored, safe to call from any thread
+    static bool      hasTexture(std::string name);
+    // decodes an image file without touching GL state, safe to call from any thread
+    static ImageData decodeImage(const char* file);
+    // decodes an encoded image (png, jpg...) held in memory, safe to call from any thread
+    static ImageData decodeImage(const unsigned char* data, size_t size);
     // properly de-allocates all loaded resources
     static void      clear();
 private:
@@ -40,6 +51,8 @@ private:
     static Shader    loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile = nullptr);
     // loads a single texture from file
     static Texture2D loadTextureFromFile(const char* file);
+    // loads a single texture from decoded pixels
+    static Texture2D loadTextureFromImage(const ImageData& image, const char* file);
     // loads a single texture from color
     static Texture2D loadTextureFromColor(const glm::vec4 color);
 
@@ -47,4 +60,6 @@ private:
     static std::map<std::string, FrameBuffer> frameBuffers;
     static std::map<std::string, Shader>      shaders;
     static std::map<std::string, Texture2D>   textures;
+    // guards textures, which import worker threads query while the GL thread adds to it
+    static std::mutex                         texturesMutex;
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <rapidjson/document.h>
@@ -7,6 +8,7 @@
 #include <vector>
 
 #include "animation.hpp"
+#include "import_profile.hpp"
 #include "light.hpp"
 #include "object_3d.hpp"
 #include "object_reader.hpp"
@@ -18,9 +20,48 @@ public:
 	glm::vec3 backgroundColor;
 	std::vector<Object3D*> objects;
 	std::vector<Animation> animations;
+	// summed import stage timings of the objects loaded by the last parse
+	ImportStats importStats;
 
 	Scene(): backgroundColor(glm::vec3(0.8f)) { }
 
+	~Scene() {
+		clear();
+	}
+
+	Scene(const Scene&) = delete;
+	Scene& operator=(const Scene&) = delete;
+
+	/**
+	 * Deletes the objects and their animations. The geometry of an object is released with the
+	 * last one using it, so this must run while the GL context exists.
+	 */
+	void clear() {
+		for (Object3D* obj : objects) {
+			delete obj;
+		}
+		objects.clear();
+		animations.clear();
+	}
+
+	/**
+	 * Deletes one object, removing it from the animations first. Animations left without objects
+	 * are dropped.
+	 *
+	 * @param index The index of the object in objects.
+	 */
+	void deleteObject(size_t index) {
+		Object3D* obj = objects[index];
+		for (Animation& animation : animations) {
+			animation.remove(obj);
+		}
+		animations.erase(std::remove_if(animations.begin(), animations.end(), [](Animation& animation) {
+			return animation.empty();
+		}), animations.end());
+		objects.erase(objects.begin() + index);
+		delete obj;
+	}
+
 	/**
 	 * Parses a JSON file and returns a Scene object.
 	 *
@@ -45,6 +86,7 @@ public:
 		}
 
 		const rapidjson::Value& sceneJson = doc["scene"];
+		importStats = ImportStats();
 
 		// Parse objects
 		if (sceneJson.HasMember("objects")) {
@@ -75,14 +117,22 @@ private:
 		ObjectReader objReader;
 
 		for (auto& o : objectsJson.GetArray()) {
-			if (!o.HasMember("path")) {
-				std::cerr << "Error parsing object from JSON: \"path\" member not found" << std::endl;
+			if (!o.HasMember("path") || !o["path"].IsString()) {
+				std::cerr << "Error parsing object from JSON: \"path\" member not found or not a string" << std::endl;
 				continue;
 			}
 			// Parse object
 			std::string objectFilePath = o["path"].GetString();
+			ImportProfile profile = ImportProfile_Fast;
+			if (o.HasMember("profile")) {
+				if (!o["profile"].IsString()) {
+					std::cerr << "Error parsing object from JSON: profile is not a string, using \"fast\"" << std::endl;
+				} else if (!parseImportProfile(o["profile"].GetString(), profile)) {
+					std::cerr << "Error parsing object from JSON: unknown profile \"" << o["profile"].GetString() << "\", using \"fast\"" << std::endl;
+				}
+			}
 			TransformableGroup objGroup;
-			for (Object3D* obj : objReader.readModel(objectFilePath.c_str())) {
+			for (Object3D* obj : objReader.readModel(objectFilePath.c_str(), profile)) {
 				if (o.HasMember("initialPosition")) {
 					const rapidjson::Value& initialPositionJson = o["initialPosition"];
 					obj->position = glm::vec3(initialPositionJson[0].GetFloat(), initialPositionJson[1].GetFloat(), initialPositionJson[2].GetFloat());
@@ -101,6 +151,7 @@ private:
 				objects.push_back(obj);
 				objGroup.add(objects.size() - 1, objects[objects.size() - 1]);
 			}
+			importStats.add(objReader.getLastStats());
 			// Parse animation
 			if (o.HasMember("animation")) {
 				const rapidjson::Value& animationJson = o["animation"];
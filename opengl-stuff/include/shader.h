@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
@@ -10,6 +12,9 @@
 // General purpose shader object. Compiles from file, generates
 // compile/link-time error messages and hosts several utility 
 // functions for easy management.
+// The locations of the active uniforms are read once after linking, so setting a uniform by name
+// costs a hash lookup instead of a driver query. Uniforms set for every object are best set through
+// the location overloads, with locations kept from getUniformLocation().
 class Shader
 {
 public:
@@ -31,7 +36,23 @@ public:
     void    setVector4f(const char* name, float x, float y, float z, float w, bool useShader = false);
     void    setVector4f(const char* name, const glm::vec4& value, bool useShader = false);
     void    setMatrix4(const char* name, const glm::mat4& matrix, bool useShader = false);
+    // connects a uniform block of the program to a uniform buffer binding point, if the program uses the block
+    void    bindUniformBlock(const char* blockName, GLuint binding);
+    // location of an active uniform, or -1 (which the setters ignore) if the program has no such uniform
+    GLint   getUniformLocation(const char* name) const;
+    // utility functions taking a location from getUniformLocation()
+    void    setFloat(GLint location, float value, bool useShader = false);
+    void    setInteger(GLint location, int value, bool useShader = false);
+    void    setVector2f(GLint location, const glm::vec2& value, bool useShader = false);
+    void    setVector3f(GLint location, const glm::vec3& value, bool useShader = false);
+    void    setVector4f(GLint location, const glm::vec4& value, bool useShader = false);
+    void    setMatrix4(GLint location, const glm::mat4& matrix, bool useShader = false);
 private:
+    // active uniforms by name, filled after linking and shared by the copies of the shader
+    std::shared_ptr<const std::unordered_map<std::string, GLint>> uniformLocations;
+
+    // reads the names and locations of the active uniforms of the linked program
+    void    loadUniformLocations();
     // checks if compilation or linking failed and if so, print the error logs
     void    checkCompileErrors(unsigned int object, std::string type);
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glad/glad.h>
+
+#include "gpu_memory.h"
+
+// A static class that streams transient vertex data (text quads, overlays) to the GPU through one
+// ring buffer, so nothing has to wait for the GPU to finish reading the previous contents.
+// With GL 4.4 the ring is persistently mapped and split into one region per frame in flight: a
+// frame writes into its region and fences it, the region is reused once that fence has signaled.
+// On older contexts the buffer is orphaned at the first upload of every frame and written with
+// unsynchronized maps, the driver hands out fresh storage while the GPU still reads the old one.
+// A region that runs out of space grows, the ring is then recreated larger.
+// Uploads GL buffers, so it must only be used from the thread that owns the GL context.
+class StreamBuffer
+{
+public:
+    // copies size bytes into the current frame's region and returns their offset in getBuffer(),
+    // a multiple of alignment. The data can be drawn from until the end of the frame.
+    static size_t upload(const void* data, size_t size, size_t alignment);
+    // buffer the offsets refer to. It changes when the ring grows, bind it after uploading.
+    static GLuint getBuffer();
+    // fences the data streamed during the frame and moves on to the next region, once per frame
+    static void endFrame();
+    // bytes streamed during the last finished frame
+    static size_t getFrameBytes();
+    // bytes of buffer storage held by the ring
+    static size_t getCapacity();
+    // whether the ring is persistently mapped, otherwise it is orphaned every frame
+    static bool isPersistent();
+    // deletes the buffer and fences, must be called while the context exists
+    static void release();
+private:
+    // private constructor, all functions are static
+    StreamBuffer() { }
+
+    // creates the ring with regions of at least regionSize bytes, dropping the previous one
+    static void create(size_t regionSize);
+    // waits until the GPU is done with the current region, or orphans the buffer
+    static void acquireRegion();
+
+    static GLuint buffer;
+    static unsigned char* mapped; // persistent mapping of the whole ring, null when orphaning
+    static bool persistent;
+    static size_t regionSize;
+    static size_t region;          // region the current frame writes into
+    static bool regionAcquired;    // whether the current frame has uploaded anything yet
+    static size_t head;            // next free byte of the region
+    static GLsync fences[];
+    static size_t frameBytes;
+    static size_t lastFrameBytes;
+    static GpuMemory::ResourceId memoryId;
+};
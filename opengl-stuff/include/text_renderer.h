@@ -3,8 +3,10 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <map>
+#include <vector>
 
 #include "font.h"
+#include "gpu_memory.h"
 #include "shader.h"
 #include "texture.h"
 
@@ -36,6 +38,13 @@ public:
     Shader shader;
 
     TextRenderer(unsigned int width, unsigned int height, Font font);
+    ~TextRenderer();
+
+    TextRenderer(const TextRenderer&) = delete;
+    TextRenderer& operator=(const TextRenderer&) = delete;
+
+    // deletes the glyph textures and the VAO, must be called while the context exists
+    void release();
 
     // renders a string of text using the precompiled list of characters
     void renderText(std::string text, float x, float y);
@@ -47,12 +56,18 @@ public:
 
 
 private:
-    unsigned int VAO, VBO;
+    unsigned int VAO;
+    // the glyph textures, accounted as one resource
+    GpuMemory::ResourceId glyphMemoryId = GpuMemory::NONE;
+    // quads of the text being rendered, streamed through StreamBuffer in one upload
+    std::vector<glm::vec4> vertices;
     TextAlignment horizontalAlignment;
     glm::vec4 color;
     float scale;
     
     // pre-compiles a list of characters from the given font
     void load(std::string font, unsigned int fontSize);
+    // deletes the glyph textures of the loaded font
+    void releaseGlyphs();
     unsigned int getPositionX(unsigned int posX, std::string text, float scale);
 };
\ No newline at end of file
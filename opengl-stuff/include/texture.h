@@ -1,9 +1,24 @@
 #pragma once
 
+#include <memory>
+
 #include <glad/glad.h>
 
+#include "gpu_memory.h"
+
+// Decoded pixels of an image file, ready to be uploaded as a texture.
+// Decoding needs no GL context, so it can happen on worker threads.
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    std::shared_ptr<unsigned char> pixels; // null if the image could not be decoded
+};
+
 // Texture2D is able to store and configure a texture in OpenGL.
 // It also hosts utility functions for easy management.
+// It owns its texture object: it can be moved but not copied, and deletes the texture when destroyed.
+// ResourceManager keeps the loaded textures, everything else refers to them.
 class Texture2D {
 public:
     // holds the ID of the texture object, used for all texture operations to reference to this particular texture
@@ -18,10 +33,17 @@ public:
     unsigned int wrapT; // wrapping mode on T axis
     unsigned int filterMin; // filtering mode if texture pixels < screen pixels
     unsigned int filterMax; // filtering mode if texture pixels > screen pixels
+    // entry of the texture in GpuMemory, tracked as a texture named "texture" until its owner describes it
+    GpuMemory::ResourceId memoryId;
 
     // constructor (sets default texture modes)
     Texture2D();
-    // generates texture from image data
+    ~Texture2D();
+    Texture2D(const Texture2D&) = delete;
+    Texture2D& operator=(const Texture2D&) = delete;
+    Texture2D(Texture2D&& other) noexcept;
+    Texture2D& operator=(Texture2D&& other) noexcept;
+    // generates texture from image data, replacing the texture held so far
     void generate(unsigned int width, unsigned int height, unsigned char* data);
     // binds the texture as the current active GL_TEXTURE_2D texture object
     void bind() const;
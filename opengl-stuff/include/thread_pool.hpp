@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads consuming a shared task queue.
+// The shared() pool is sized after the hardware and is meant for short CPU bound jobs,
+// like converting the meshes of an imported model.
+class ThreadPool {
+public:
+    ThreadPool(unsigned int threadCount) {
+        for (unsigned int i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Pool shared by the whole application. The calling thread also works during parallelFor,
+    // so one thread less than the hardware supports is created. hardware_concurrency() may be 0
+    // when it is unknown, one thread is created then.
+    static ThreadPool& shared() {
+        static ThreadPool pool(getSharedThreadCount());
+        return pool;
+    }
+
+    static unsigned int getSharedThreadCount() {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push(std::move(task));
+        }
+        condition.notify_one();
+    }
+
+    // Number of threads that take part in a parallelFor (workers + caller)
+    unsigned int getConcurrency() const {
+        return static_cast<unsigned int>(workers.size()) + 1;
+    }
+
+    /**
+     * Calls func(i) for every i in [0, count) and blocks until all calls are done.
+     *
+     * Iterations are handed out one at a time, so uneven work (a huge mesh next to tiny ones)
+     * is balanced between threads. The calling thread also consumes iterations, which makes
+     * it safe to call from inside a pool task.
+     * If a call throws, the iterations not started yet are skipped and the first exception is
+     * rethrown on the calling thread once the calls in flight have returned.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& func) {
+        if (count == 0) {
+            return;
+        }
+        struct ForState {
+            std::atomic<size_t> next{ 0 };
+            std::atomic<size_t> done{ 0 };
+            std::atomic<bool> failed{ false };
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        std::shared_ptr<ForState> state = std::make_shared<ForState>();
+        // Helpers that start after all iterations were taken leave without touching func
+        auto work = [state, count, &func]() {
+            size_t i;
+            while ((i = state->next++) < count) {
+                if (!state->failed) {
+                    try {
+                        func(i);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        if (!state->error) {
+                            state->error = std::current_exception();
+                        }
+                        state->failed = true;
+                    }
+                }
+                // Skipped iterations count as done, so the wait below always ends
+                if (++state->done == count) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->finished.notify_all();
+                }
+            }
+        };
+        size_t helpers = std::min(count - 1, workers.size());
+        for (size_t i = 0; i < helpers; ++i) {
+            submit(work);
+        }
+        work();
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&]() { return state->done == count; });
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+};
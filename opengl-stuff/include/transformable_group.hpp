@@ -2,6 +2,7 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <iterator>
 #include <map>
 
 #include "object_3d.hpp"
@@ -25,6 +26,17 @@ public:
         updateAttributes();
     }
 
+    // Removes every entry pointing at transformable, used before it is deleted
+    void remove(const Transformable* transformable) {
+        size_t count = transformables.size();
+        for (auto it = transformables.begin(); it != transformables.end();) {
+            it = it->second == transformable ? transformables.erase(it) : std::next(it);
+        }
+        if (transformables.size() != count) {
+            updateAttributes();
+        }
+    }
+
     void clear() {
         transformables.clear();
         updateAttributes();
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+// Layouts a Geometry can upload its vertices with, chosen for every new upload in the Objects
+// window (GeometryRegistry::setVertexFormat). Both are interleaved, each has its own GeometryArena pools:
+//  - float: FloatVertex, 32 bytes per textured vertex
+//  - compressed: CompressedVertex, 12 bytes per textured vertex.
+//    Positions are quantized to 16 bits inside the mesh bounds and dequantized by the vertex
+//    shader (positionScale/positionOffset), normals are octahedral-encoded in two bytes and
+//    texture coordinates are half floats
+enum VertexFormat_
+{
+	VertexFormat_Float,
+	VertexFormat_Compressed,
+	VertexFormat_Count
+};
+typedef int VertexFormat;
+
+const char* const VERTEX_FORMAT_NAMES[VertexFormat_Count] = { "float", "compressed" };
+
+inline const char* getVertexFormatName(VertexFormat format) {
+	if (format < 0 || format >= VertexFormat_Count) {
+		return VERTEX_FORMAT_NAMES[VertexFormat_Float];
+	}
+	return VERTEX_FORMAT_NAMES[format];
+}
+
+// Finds the format with the given name, returns false if there is none
+inline bool parseVertexFormat(const std::string& name, VertexFormat& format) {
+	for (int i = 0; i < VertexFormat_Count; ++i) {
+		if (name == VERTEX_FORMAT_NAMES[i]) {
+			format = i;
+			return true;
+		}
+	}
+	return false;
+}
+
+// One vertex of the float layout. The texture coordinates are left out of the buffer (and the
+// stride) when the mesh has none.
+struct FloatVertex {
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 texCoord;
+};
+static_assert(sizeof(FloatVertex) == 32, "FloatVertex must be tightly packed");
+
+// One vertex of the compressed layout. The texture coordinates are left out of the buffer (and the
+// stride) when the mesh has none.
+struct CompressedVertex {
+	uint16_t position[3];  // normalized unsigned shorts, 0 and 65535 are the bounds of the mesh
+	int8_t normal[2];      // octahedral encoding scaled by 127, decoded by the vertex shader
+	uint16_t texCoord[2];  // half floats
+};
+static_assert(sizeof(CompressedVertex) == 12, "CompressedVertex must be tightly packed");
+
+// Maps a unit vector onto the [-1, 1] square: the upper half of the octahedron is projected
+// straight down, the lower half is folded over the diagonals
+inline glm::vec2 encodeOctahedral(const glm::vec3& normal) {
+	float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (length == 0.0f) {
+		return glm::vec2(0.0f);
+	}
+	glm::vec3 n = normal / length;
+	if (n.z >= 0.0f) {
+		return glm::vec2(n.x, n.y);
+	}
+	return glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+		(1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+}
+
+inline uint16_t quantizeUnorm16(float value) {
+	return static_cast<uint16_t>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+inline int8_t quantizeSnorm8(float value) {
+	return static_cast<int8_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 127.0f));
+}
+
+// Packs one vertex, positionMin and positionExtent being the bounds of the whole mesh
+inline CompressedVertex compressVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec2& texCoord,
+	const glm::vec3& positionMin, const glm::vec3& positionExtent) {
+	CompressedVertex vertex;
+	for (int axis = 0; axis < 3; ++axis) {
+		float extent = positionExtent[axis];
+		vertex.position[axis] = extent > 0.0f ? quantizeUnorm16((position[axis] - positionMin[axis]) / extent) : 0;
+	}
+	glm::vec2 octahedral = encodeOctahedral(normal);
+	vertex.normal[0] = quantizeSnorm8(octahedral.x);
+	vertex.normal[1] = quantizeSnorm8(octahedral.y);
+	vertex.texCoord[0] = glm::packHalf1x16(texCoord.x);
+	vertex.texCoord[1] = glm::packHalf1x16(texCoord.y);
+	return vertex;
+}
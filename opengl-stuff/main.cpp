@@ -13,13 +13,19 @@
 #include <iostream>
 #include <fstream>
 
+#include <allocation_counter.h>
+#include <async_importer.hpp>
 #include <camera.hpp>
 #include <font.h>
+#include <frustum_culling.h>
+#include <gl_state.h>
+#include <gpu_memory.h>
 #include <mesh.hpp>
 #include <renderer.hpp>
 #include <resource_manager.h>
 #include <scene.hpp>
 #include <shader.h>
+#include <stream_buffer.h>
 #include <texture.h>
 #include <text_renderer.h>
 #include <transformable_group.hpp>
@@ -33,13 +39,19 @@ void mouseCursorPosCallback(GLFWwindow* window, double xpos, double ypos);
 void mouseScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 static bool rayIntersectsTriangle(const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float* intersection);
+static bool rayIntersectsSphere(const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& center, float radius);
+static bool rayIntersectsTriangles(const glm::vec3& origin, const glm::vec3& dir, const std::vector<glm::vec3>& vertices, const std::vector<GLuint>& indices,
+    size_t first, size_t end, float* intersection);
 void markMesh(GLFWwindow* window, int meshIndex);
 void deleteSelectedObjects();
+void sortSceneObjects();
 Object3D* getSelectedObject();
 
 // Settings
 const unsigned int SCR_WIDTH = 1366;
 const unsigned int SCR_HEIGHT = 768;
+// Time per frame spent uploading meshes of a background import
+const double IMPORT_BUDGET_MS = 4.0;
 
 float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
@@ -53,6 +65,11 @@ Scene scene;
 
 // Selected objects
 TransformableGroup selectedObjects;
+// Heap allocations made by the ray test of the last click, 0 unless something copies geometry
+size_t lastPickAllocations = 0;
+
+// GPU memory the scene is meant to fit in, the memory window warns above it
+float gpuMemoryBudgetMB = 512.0f;
 
 // Timing
 float deltaTime = 0.0f;	// time between current frame and last frame
@@ -85,7 +102,7 @@ int main() {
         return -1;
     }
     // Configure global opengl state
-    glEnable(GL_DEPTH_TEST);
+    GLState::setDepthTest(true);
     // ImGUI: initialize and configure
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
@@ -97,11 +114,12 @@ int main() {
     // -------------------------------------------------------------------
     // File browser
     ImGui::FileBrowser fileDialog;
-    fileDialog.SetTypeFilters({ ".obj", ".json"});
+    fileDialog.SetTypeFilters({ ".obj", ".gltf", ".glb", ".json"});
     // Object renderer
     Renderer renderer(glm::vec2(SCR_WIDTH, SCR_HEIGHT), camera, scene.light);
-    // Object reader
-    ObjectReader objReader;
+    // Background model importer
+    AsyncImporter asyncImporter;
+    ImportProfile importProfile = ImportProfile_Fast;
     // Text renderer
     TextRenderer textRenderer(SCR_WIDTH, SCR_HEIGHT, Font("assets/fonts/Gobold Regular.otf", 11));
     textRenderer.setHorizontalAlignment(TextLeft);
@@ -132,14 +150,29 @@ int main() {
         textRenderer.renderText("[Alt] Multiple selection", 10.0f, 70.0f);
         textRenderer.renderText("[Right click] Camera", 10.0f, 85.0f);
 
+        // Add the meshes the background import finished since the last frame
+        std::vector<Object3D*> importedObjects = asyncImporter.poll(IMPORT_BUDGET_MS);
+        if (!importedObjects.empty()) {
+            scene.objects.insert(scene.objects.end(), importedObjects.begin(), importedObjects.end());
+            sortSceneObjects();
+        }
+        // Pack the geometry buffers that deleted objects left mostly empty
+        GeometryArena::compact();
+
         // Object rendering
+        renderer.beginFrame();
+        renderer.cullObjects(scene.objects);
         for (int x = 0; x < scene.objects.size(); x++) {
+            if (!renderer.isVisible(x)) {
+                continue;
+            }
             int renderModes = RenderModes_Normal;
             if (selectedObjects.contains(x)) {
                 renderModes |= RenderModes_Wireframe;
             }
-            renderer.render(*scene.objects[x], renderModes);
+            renderer.submit(*scene.objects[x], renderModes);
         }
+        renderer.flush();
 
         // Animation
         if (scene.animations.size() > 0) {
@@ -153,23 +186,21 @@ int main() {
         ImGui::Begin("Objects", (bool*)0, ImGuiWindowFlags_AlwaysAutoResize);
 
             // Import object/scene button
+            ImGui::BeginDisabled(asyncImporter.isBusy());
             if (ImGui::Button("Import")) {
                 fileDialog.Open();
             }
+            ImGui::EndDisabled();
             fileDialog.Display();
             if (fileDialog.HasSelected()) {
-                // Object import
-                if (fileDialog.GetSelected().extension().string() == ".obj") {
-                    for (Object3D* obj : objReader.readModel(fileDialog.GetSelected().string().c_str()))
-                        scene.objects.push_back(obj);
+                // Object import, runs in the background
+                if (fileDialog.GetSelected().extension().string() != ".json") {
+                    asyncImporter.start(fileDialog.GetSelected().string(), importProfile);
                 // JSON scene import
                 } else {
                     scene.parse(fileDialog.GetSelected().string().c_str());
+                    sortSceneObjects();
                 }
-                // Sort objects putting the transparent ones at the end
-                std::sort(scene.objects.begin(), scene.objects.end(), [](Object3D* a, Object3D* b) {
-                    return a->mesh.getMaterial().opacity > b->mesh.getMaterial().opacity;
-                });
                 fileDialog.ClearSelected();
             }
 
@@ -182,15 +213,60 @@ int main() {
             // Clear scene button
             ImGui::SameLine();
             if (ImGui::Button("Clear scene")) {
-                scene.objects.clear();
-                scene.animations.clear();
                 selectedObjects.clear();
+                scene.clear();
             }
 
+            // Post-processing of imported objects, scenes set it per object
+            ImGui::SetNextItemWidth(140.0f);
+            ImGui::Combo("Import profile", &importProfile, IMPORT_PROFILE_NAMES, ImportProfile_Count);
+            // Applies to the meshes imported from now on, the loaded ones keep their buffers
+            int vertexFormat = GeometryRegistry::getVertexFormat();
+            ImGui::SetNextItemWidth(140.0f);
+            if (ImGui::Combo("Vertex format", &vertexFormat, VERTEX_FORMAT_NAMES, VertexFormat_Count)) {
+                GeometryRegistry::setVertexFormat(vertexFormat);
+            }
+            ImGui::Text("Vertex buffers: %.2f MB (arena %.2f MB in %zu VAOs)", GeometryRegistry::getVertexMemory() / (1024.0 * 1024.0),
+                GeometryArena::getBufferMemory() / (1024.0 * 1024.0), GeometryArena::getPoolCount());
+
+            // Triangles of the LOD levels the renderer picked in the last frame, culled objects draw none
+            ImGui::Checkbox("Automatic LOD", &renderer.automaticLod);
+            size_t lodTriangles[LOD_SCREEN_SIZE_COUNT + 1] = {};
+            size_t fullTriangles = 0;
+            for (size_t i = 0; i < scene.objects.size(); ++i) {
+                Mesh& mesh = scene.objects[i]->mesh;
+                fullTriangles += mesh.getLodTriangleCount(0);
+                if (renderer.isVisible(i)) {
+                    lodTriangles[std::min(mesh.getLod(), LOD_SCREEN_SIZE_COUNT)] += mesh.getLodTriangleCount(mesh.getLod());
+                }
+            }
+            size_t drawnTriangles = lodTriangles[0] + lodTriangles[1] + lodTriangles[2] + lodTriangles[3];
+            ImGui::Text("Triangles: %zu of %zu (LOD 0: %zu, 1: %zu, 2: %zu, 3: %zu)", drawnTriangles, fullTriangles,
+                lodTriangles[0], lodTriangles[1], lodTriangles[2], lodTriangles[3]);
+            if (selectedObjects.size() == 1) {
+                Mesh& mesh = getSelectedObject()->mesh;
+                std::string levels;
+                for (size_t lod = 0; lod < mesh.getLodCount(); ++lod) {
+                    levels += (lod > 0 ? " / " : "") + std::to_string(mesh.getLodTriangleCount(lod));
+                }
+                ImGui::Text("Selected LODs: %s triangles, drawing LOD %zu", levels.c_str(), mesh.getLod());
+            }
+            ImGui::Checkbox("Frustum culling", &renderer.frustumCulling);
+            ImGui::SameLine();
+            ImGui::Text("Objects: %zu of %zu visible (%s)", renderer.objectCount - renderer.culledObjectCount, renderer.objectCount,
+                FrustumCulling::isVectorized() ? "SSE" : "scalar");
+            ImGui::Checkbox("Meshlet culling", &renderer.meshletCulling);
+            ImGui::Text("Meshlets: %zu of %zu culled", renderer.culledMeshletCount, renderer.meshletCount);
+            ImGui::Text("Draw calls: %zu for %zu objects, state changes: %zu (%zu redundant dropped)", renderer.drawCallCount,
+                renderer.instanceCount, GLState::getIssuedCalls(), GLState::getElidedCalls());
+            ImGui::Text("Last pick: %zu allocations", lastPickAllocations);
+            ImGui::Text("Streamed: %.1f KB per frame (%s, %.0f KB ring)", StreamBuffer::getFrameBytes() / 1024.0,
+                StreamBuffer::isPersistent() ? "persistent" : "orphaned", StreamBuffer::getCapacity() / 1024.0);
+
             // List of meshes in scene
             if (ImGui::BeginListBox("##meshes-list", ImVec2(300.0f, 200.0f))) {
                 for (int i = 0; i < scene.objects.size(); i++) {
-                    std::string originalMeshName = scene.objects[i]->mesh.getName();
+                    const std::string& originalMeshName = scene.objects[i]->mesh.getName();
                     std::string meshName = originalMeshName.empty() ? "mesh_" + std::to_string(i) : originalMeshName;
                     if (ImGui::Selectable(meshName.c_str(), selectedObjects.contains(i))) {
                         markMesh(window, i);
@@ -198,6 +274,17 @@ int main() {
                 }
                 ImGui::EndListBox();
             }
+
+            // Background import progress
+            if (asyncImporter.isBusy()) {
+                ImGui::ProgressBar(asyncImporter.getProgress(), ImVec2(240.0f, 0.0f));
+                ImGui::SameLine();
+                if (ImGui::Button("Cancel")) {
+                    asyncImporter.cancel();
+                }
+            } else if (asyncImporter.hasFailed()) {
+                ImGui::Text("Import failed: %s", asyncImporter.getFilePath().c_str());
+            }
         ImGui::End();
 
         // --------------------------------------------------------------
@@ -243,29 +330,71 @@ int main() {
         ImGui::DragScalar("Specular##specular_strength", ImGuiDataType_Float, &scene.light.specularStrength, 0.01f);
         ImGui::End();
 
+        // --------------------------------------------------------------
+        // GPU memory window
+        ImGui::Begin("GPU memory", (bool*)0, ImGuiWindowFlags_AlwaysAutoResize);
+        const double totalMB = GpuMemory::getTotalBytes() / 1048576.0;
+        ImGui::Text("Total: %.1f MB (peak %.1f MB)", totalMB, GpuMemory::getPeakBytes() / 1048576.0);
+        ImGui::DragScalar("Budget (MB)##gpu_memory_budget", ImGuiDataType_Float, &gpuMemoryBudgetMB, 1.0f);
+        if (gpuMemoryBudgetMB > 0.0f) {
+            ImGui::ProgressBar(static_cast<float>(totalMB / gpuMemoryBudgetMB), ImVec2(240.0f, 0.0f));
+            if (totalMB > gpuMemoryBudgetMB) {
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Over budget by %.1f MB", totalMB - gpuMemoryBudgetMB);
+            }
+        }
+        ImGui::Separator();
+        for (int category = 0; category < GpuMemoryCategory_Count; category++) {
+            ImGui::Text("%s: %.2f MB", GPU_MEMORY_CATEGORY_NAMES[category], GpuMemory::getCategoryBytes(category) / 1048576.0);
+            if (category == GpuMemoryCategory_Textures || category == GpuMemoryCategory_RenderTargets) {
+                for (const auto& format : GpuMemory::getFormatBytes(category)) {
+                    ImGui::BulletText("%s: %.2f MB", format.first.c_str(), format.second / 1048576.0);
+                }
+            }
+        }
+        ImGui::Separator();
+        ImGui::Text("Largest resources");
+        for (const GpuResource& resource : GpuMemory::getLargestResources(10)) {
+            ImGui::BulletText("%.2f MB  %s (%s)", resource.bytes / 1048576.0, resource.name.c_str(), resource.format.c_str());
+        }
+        ImGui::End();
+
         // --------------------------------------------------------------
         // Material window
         if (selectedObjects.size() == 1) {
-            Material* material = &getSelectedObject()->mesh.getMaterial();
+            // Edits a copy, the material may be shared with the other meshes of the import
+            Mesh& mesh = getSelectedObject()->mesh;
+            Material material = mesh.getMaterial();
             ImGui::Begin("Material", (bool*)0, ImGuiWindowFlags_AlwaysAutoResize);
-            if (material->texture.id != 0) {
+            if (material.texture != nullptr) {
                 ImGui::Text("Texture");
-                ImGui::Image((void*)material->texture.id, ImVec2(150.0f, 150.0f));
+                ImGui::Image((void*)material.texture->id, ImVec2(150.0f, 150.0f));
                 ImGui::Separator();
             }
-            ImGui::ColorEdit3("Ambient##material_ambient", (float*)&material->ambientColor);
-            ImGui::ColorEdit3("Diffuse##material_diffuse", (float*)&material->diffuseColor);
-            ImGui::ColorEdit3("Specular##material_specular", (float*)&material->specularColor);
-            ImGui::ColorEdit3("Emissive##material_emissive", (float*)&material->emissiveColor);
-            ImGui::DragScalar("Shininess##material_shininess", ImGuiDataType_Float, &material->shininess, 0.01f);
-            ImGui::DragScalar("Opacity##material_opacity", ImGuiDataType_Float, &material->opacity, 0.01f);
+            ImGui::ColorEdit3("Ambient##material_ambient", (float*)&material.ambientColor);
+            ImGui::ColorEdit3("Diffuse##material_diffuse", (float*)&material.diffuseColor);
+            ImGui::ColorEdit3("Specular##material_specular", (float*)&material.specularColor);
+            ImGui::ColorEdit3("Emissive##material_emissive", (float*)&material.emissiveColor);
+            ImGui::DragScalar("Shininess##material_shininess", ImGuiDataType_Float, &material.shininess, 0.01f);
+            ImGui::DragScalar("Opacity##material_opacity", ImGuiDataType_Float, &material.opacity, 0.01f);
             ImGui::End();
+            // The first change gives the selected mesh its own material
+            if (!material.looksLike(mesh.getMaterial())) {
+                bool opacityChanged = material.opacity != mesh.getMaterial().opacity;
+                mesh.getOwnMaterial() = material;
+                if (opacityChanged) {
+                    sortSceneObjects();
+                }
+            }
         }
 
         // --------------------------------------------------------------
         // Render windows
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        // Fence this frame's streamed vertices
+        StreamBuffer::endFrame();
+        // ImGui drew behind the state cache's back
+        GLState::endFrame();
         // OpenGL stuff
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -275,6 +404,13 @@ int main() {
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
+    // Objects, textures, framebuffers and the stream buffer must be deleted while the context exists
+    selectedObjects.clear();
+    scene.clear();
+    renderer.release();
+    textRenderer.release();
+    ResourceManager::clear();
+    StreamBuffer::release();
     glfwTerminate();
     return 0;
 }
@@ -340,6 +476,7 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
     float closestIntersection = std::numeric_limits<float>::max();
     int closestIntersectionIndex = -1;
 
+    size_t allocationsBefore = AllocationCounter::getCount();
     for (int x = 0; x < scene.objects.size(); ++x) {
         glm::mat4 model = scene.objects[x]->getModelMatrix();
 
@@ -347,22 +484,27 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
         glm::vec3 worldFar = glm::unProject(glm::vec3(float(cursorX), float(windowHeight - cursorY), 1.0f), view * model, projection, viewport);
         glm::vec3 rayDir = glm::normalize(worldFar - worldNear);
 
-        Mesh mesh = scene.objects[x]->mesh;
-        std::vector<glm::vec3> verticesData = mesh.getVertices();
-        std::vector<GLuint> indices = mesh.getIndices();
-
-        for (uint32_t i = 0; i < indices.size(); i += 3) {
-            if (i + 3 >= indices.size())
-                break;
-            float intersectionPos;
-            if (rayIntersectsTriangle(worldNear, rayDir, verticesData[indices[i]], verticesData[indices[i + 1]], verticesData[indices[i + 2]], &intersectionPos)) {
-                if (intersectionPos < closestIntersection) {
-                    closestIntersection = intersectionPos;
-                    closestIntersectionIndex = x;
-                }
+        Mesh& mesh = scene.objects[x]->mesh;
+        const std::vector<glm::vec3>& verticesData = mesh.getVertices();
+        const std::vector<GLuint>& indices = mesh.getIndices();
+        const std::vector<Meshlet>& meshlets = mesh.getMeshlets();
+
+        // Meshlets are tested first, only the triangles of the ones the ray goes through are
+        bool hit = false;
+        if (meshlets.empty()) {
+            hit = rayIntersectsTriangles(worldNear, rayDir, verticesData, indices, 0, indices.size(), &closestIntersection);
+        }
+        for (const Meshlet& meshlet : meshlets) {
+            if (rayIntersectsSphere(worldNear, rayDir, meshlet.center, meshlet.radius)
+                && rayIntersectsTriangles(worldNear, rayDir, verticesData, indices, meshlet.firstIndex, meshlet.firstIndex + meshlet.indexCount, &closestIntersection)) {
+                hit = true;
             }
         }
+        if (hit) {
+            closestIntersectionIndex = x;
+        }
     }
+    lastPickAllocations = AllocationCounter::getCount() - allocationsBefore;
 
     if (closestIntersectionIndex != -1) {
         markMesh(window, closestIntersectionIndex);
@@ -491,15 +633,38 @@ void markMesh(GLFWwindow* window, int meshIndex) {
     }
 }
 
-// Delete all selected meshes
+// Delete all selected meshes, back to front so the indices of the ones left to delete stay valid
 void deleteSelectedObjects() {
-    scene.objects.erase(std::remove_if(scene.objects.begin(), scene.objects.end(), [&](Object3D* objPtr) {
-        int index = std::distance(scene.objects.begin(), std::find(scene.objects.begin(), scene.objects.end(), objPtr));
-        return selectedObjects.contains(index);
-        }), scene.objects.end());
+    for (int x = static_cast<int>(scene.objects.size()) - 1; x >= 0; x--) {
+        if (selectedObjects.contains(x)) {
+            scene.deleteObject(x);
+        }
+    }
     selectedObjects.clear();
 }
 
+// Sort objects putting the transparent ones at the end, keeping the same objects selected
+void sortSceneObjects() {
+    std::vector<Object3D*> selected;
+    for (int x = 0; x < scene.objects.size(); x++) {
+        if (selectedObjects.contains(x)) {
+            selected.push_back(scene.objects[x]);
+        }
+    }
+    std::stable_sort(scene.objects.begin(), scene.objects.end(), [](Object3D* a, Object3D* b) {
+        return a->mesh.getMaterial().opacity > b->mesh.getMaterial().opacity;
+    });
+    if (selected.empty()) {
+        return;
+    }
+    selectedObjects.clear();
+    for (int x = 0; x < scene.objects.size(); x++) {
+        if (std::find(selected.begin(), selected.end(), scene.objects[x]) != selected.end()) {
+            selectedObjects.add(x, scene.objects[x]);
+        }
+    }
+}
+
 // Get the first selected object
 Object3D* getSelectedObject() {
     for (int x = 0; x < scene.objects.size(); x++) {
@@ -507,4 +672,29 @@ Object3D* getSelectedObject() {
 			return scene.objects[x];
 		}
 	}
-}
\ No newline at end of file
+}
+
+static bool rayIntersectsSphere(const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& center, float radius) {
+    glm::vec3 offset = center - origin;
+    float along = glm::dot(offset, dir);
+    float distanceSquared = glm::dot(offset, offset);
+    if (along < 0.0f && distanceSquared > radius * radius) {
+        return false; // Sphere is behind the origin
+    }
+    return distanceSquared - along * along <= radius * radius;
+}
+
+// Closest intersection with the triangles of indices[first, end), only updated when it is closer than the current one
+static bool rayIntersectsTriangles(const glm::vec3& origin, const glm::vec3& dir, const std::vector<glm::vec3>& vertices, const std::vector<GLuint>& indices,
+    size_t first, size_t end, float* intersection) {
+    bool closer = false;
+    for (size_t i = first; i + 2 < end; i += 3) {
+        float intersectionPos;
+        if (rayIntersectsTriangle(origin, dir, vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]], &intersectionPos)
+            && intersectionPos < *intersection) {
+            *intersection = intersectionPos;
+            closer = true;
+        }
+    }
+    return closer;
+}
@@ -0,0 +1,134 @@
+#include "frustum_culling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef FRUSTUM_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+
+// Whether object i is entirely behind one of the planes
+bool isOutside(const glm::vec4 planes[6], const CullingBounds& bounds, size_t i) {
+    for (int p = 0; p < 6; ++p) {
+        const glm::vec4& plane = planes[p];
+        float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] + plane.z * bounds.centerZ[i] + plane.w;
+        float boxRadius = std::abs(plane.x) * bounds.extentX[i] + std::abs(plane.y) * bounds.extentY[i] + std::abs(plane.z) * bounds.extentZ[i];
+        if (distance < -std::min(bounds.radius[i], boxRadius)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+void CullingBounds::clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    radius.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+}
+
+void CullingBounds::add(const glm::mat4& model, const glm::vec3& center, float radius, const glm::vec3& extent) {
+    glm::vec3 worldCenter = glm::vec3(model * glm::vec4(center, 1.0f));
+    glm::vec3 axisX = glm::vec3(model[0]);
+    glm::vec3 axisY = glm::vec3(model[1]);
+    glm::vec3 axisZ = glm::vec3(model[2]);
+    // Box around the transformed box (Arvo): each world axis gets the extents projected on it
+    glm::vec3 worldExtent = glm::abs(axisX) * extent.x + glm::abs(axisY) * extent.y + glm::abs(axisZ) * extent.z;
+    float scale = std::max(glm::length(axisX), std::max(glm::length(axisY), glm::length(axisZ)));
+
+    centerX.push_back(worldCenter.x);
+    centerY.push_back(worldCenter.y);
+    centerZ.push_back(worldCenter.z);
+    this->radius.push_back(radius * scale);
+    extentX.push_back(worldExtent.x);
+    extentY.push_back(worldExtent.y);
+    extentZ.push_back(worldExtent.z);
+}
+
+size_t CullingBounds::size() const {
+    return centerX.size();
+}
+
+void FrustumCulling::extractPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]) {
+    glm::mat4 rows = glm::transpose(viewProjection);
+    planes[0] = rows[3] + rows[0];
+    planes[1] = rows[3] - rows[0];
+    planes[2] = rows[3] + rows[1];
+    planes[3] = rows[3] - rows[1];
+    planes[4] = rows[3] + rows[2];
+    planes[5] = rows[3] - rows[2];
+    for (int p = 0; p < 6; ++p) {
+        planes[p] /= glm::length(glm::vec3(planes[p]));
+    }
+}
+
+size_t FrustumCulling::cull(const glm::vec4 planes[6], const CullingBounds& bounds, std::vector<uint8_t>& visible) {
+    const size_t count = bounds.size();
+    visible.resize(count);
+    size_t visibleCount = 0;
+    size_t i = 0;
+
+#ifdef FRUSTUM_CULLING_SSE
+    // Each plane coefficient is broadcast once, then four objects go through the six planes per loop
+    __m128 planeX[6], planeY[6], planeZ[6], planeW[6], planeAbsX[6], planeAbsY[6], planeAbsZ[6];
+    for (int p = 0; p < 6; ++p) {
+        planeX[p] = _mm_set1_ps(planes[p].x);
+        planeY[p] = _mm_set1_ps(planes[p].y);
+        planeZ[p] = _mm_set1_ps(planes[p].z);
+        planeW[p] = _mm_set1_ps(planes[p].w);
+        planeAbsX[p] = _mm_set1_ps(std::abs(planes[p].x));
+        planeAbsY[p] = _mm_set1_ps(std::abs(planes[p].y));
+        planeAbsZ[p] = _mm_set1_ps(std::abs(planes[p].z));
+    }
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 centerX = _mm_loadu_ps(&bounds.centerX[i]);
+        __m128 centerY = _mm_loadu_ps(&bounds.centerY[i]);
+        __m128 centerZ = _mm_loadu_ps(&bounds.centerZ[i]);
+        __m128 radius = _mm_loadu_ps(&bounds.radius[i]);
+        __m128 extentX = _mm_loadu_ps(&bounds.extentX[i]);
+        __m128 extentY = _mm_loadu_ps(&bounds.extentY[i]);
+        __m128 extentZ = _mm_loadu_ps(&bounds.extentZ[i]);
+
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; ++p) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], centerX), _mm_mul_ps(planeY[p], centerY)),
+                _mm_add_ps(_mm_mul_ps(planeZ[p], centerZ), planeW[p]));
+            __m128 boxRadius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeAbsX[p], extentX), _mm_mul_ps(planeAbsY[p], extentY)),
+                _mm_mul_ps(planeAbsZ[p], extentZ));
+            // distance < -min(radius, boxRadius)
+            __m128 limit = _mm_sub_ps(zero, _mm_min_ps(radius, boxRadius));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, limit));
+        }
+        int outsideMask = _mm_movemask_ps(outside);
+        for (int lane = 0; lane < 4; ++lane) {
+            uint8_t laneVisible = (outsideMask >> lane & 1) == 0;
+            visible[i + lane] = laneVisible;
+            visibleCount += laneVisible;
+        }
+    }
+#endif
+
+    // Objects past the last group of four, or all of them without SSE
+    for (; i < count; ++i) {
+        uint8_t objectVisible = !isOutside(planes, bounds, i);
+        visible[i] = objectVisible;
+        visibleCount += objectVisible;
+    }
+    return visibleCount;
+}
+
+bool FrustumCulling::isVectorized() {
+#ifdef FRUSTUM_CULLING_SSE
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,289 @@
+#include "geometry_arena.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "gl_state.h"
+
+namespace {
+
+// Pools start with room for this many vertices and index words and double when they are full
+const size_t INITIAL_VERTEX_CAPACITY = 1 << 16;
+const size_t INITIAL_INDEX_CAPACITY = 1 << 17;
+const size_t INDEX_WORD_SIZE = 4;
+
+size_t getIndexSize(GLenum indexType) {
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(GLuint);
+}
+
+// Smallest doubling of initial that holds required
+size_t getGrownCapacity(size_t initial, size_t current, size_t required) {
+    size_t capacity = std::max(initial, current);
+    while (capacity < required) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// Capacity a pool is packed into: twice what is used, so the next imports fit without growing
+size_t getPackedCapacity(size_t initial, size_t used) {
+    if (used == 0) {
+        return 0;
+    }
+    size_t capacity = initial;
+    while (capacity < used * 2) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// Worth packing: more than half free and split into several ranges, or four times too large
+bool needsCompaction(const RangeAllocator& allocator, size_t initial) {
+    size_t used = allocator.getUsedSize();
+    size_t capacity = allocator.getCapacity();
+    return (used * 2 < capacity && allocator.getFreeRangeCount() > 1)
+        || (capacity > initial && used * 4 < capacity)
+        || (capacity > 0 && used == 0);
+}
+
+}
+
+// Instantiate static variables
+std::vector<GeometryArena::Pool>        GeometryArena::pools(VertexFormat_Count * 2);
+std::vector<GeometryArena::Allocation>  GeometryArena::allocations;
+std::vector<GeometryArena::AllocationId> GeometryArena::freeIds;
+
+GeometryArena::AllocationId GeometryArena::allocate(VertexFormat format, bool texCoords, const void* vertices, size_t vertexCount,
+    const void* indices, size_t indexCount, GLenum indexType) {
+
+    size_t poolIndex = getPoolIndex(format, texCoords);
+    Pool& pool = pools[poolIndex];
+    pool.format = format;
+    pool.texCoords = texCoords;
+    const size_t stride = getVertexStride(format, texCoords);
+    const size_t indexBytes = indexCount * getIndexSize(indexType);
+    const size_t wordCount = (indexBytes + INDEX_WORD_SIZE - 1) / INDEX_WORD_SIZE;
+
+    size_t baseVertex = 0, firstWord = 0;
+    bool allocated = pool.vertices.allocate(vertexCount, baseVertex);
+    if (allocated && !pool.indices.allocate(wordCount, firstWord)) {
+        pool.vertices.release(baseVertex, vertexCount);
+        allocated = false;
+    }
+    if (!allocated) {
+        // Relocating packs the live ranges, so the new one always fits at the end
+        relocate(poolIndex,
+            getGrownCapacity(INITIAL_VERTEX_CAPACITY, pool.vertices.getCapacity(), pool.vertices.getUsedSize() + vertexCount),
+            getGrownCapacity(INITIAL_INDEX_CAPACITY, pool.indices.getCapacity(), pool.indices.getUsedSize() + wordCount));
+        pool.vertices.allocate(vertexCount, baseVertex);
+        pool.indices.allocate(wordCount, firstWord);
+    }
+
+    if (vertexCount > 0) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, pool.VBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, baseVertex * stride, vertexCount * stride, vertices);
+    }
+    if (indexBytes > 0) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, pool.EBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, firstWord * INDEX_WORD_SIZE, indexBytes, indices);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    Allocation allocation = { poolIndex, baseVertex, vertexCount, firstWord, wordCount, indexCount, indexType, true };
+    if (!freeIds.empty()) {
+        AllocationId id = freeIds.back();
+        freeIds.pop_back();
+        allocations[id] = allocation;
+        return id;
+    }
+    allocations.push_back(allocation);
+    return allocations.size() - 1;
+}
+
+void GeometryArena::release(AllocationId id) {
+    Allocation& allocation = allocations[id];
+    Pool& pool = pools[allocation.pool];
+    pool.vertices.release(allocation.baseVertex, allocation.vertexCount);
+    pool.indices.release(allocation.firstWord, allocation.wordCount);
+    allocation.live = false;
+    freeIds.push_back(id);
+}
+
+size_t GeometryArena::getPool(AllocationId id) {
+    return allocations[id].pool;
+}
+
+void GeometryArena::bind(AllocationId id) {
+    GLState::bindVertexArray(pools[allocations[id].pool].VAO);
+}
+
+void GeometryArena::bindInstances(GLuint buffer, size_t offset) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    for (GLuint column = 0; column < 4; ++column) {
+        glVertexAttribPointer(INSTANCE_MODEL_ATTRIBUTE + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceAttributes),
+            (void*)(offset + offsetof(InstanceAttributes, model) + column * sizeof(glm::vec4)));
+    }
+    for (GLuint column = 0; column < 3; ++column) {
+        glVertexAttribPointer(INSTANCE_NORMAL_ATTRIBUTE + column, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceAttributes),
+            (void*)(offset + offsetof(InstanceAttributes, normalMatrix) + column * sizeof(glm::vec3)));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryArena::draw(AllocationId id, size_t instanceCount) {
+    const Allocation& allocation = allocations[id];
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(allocation.indexCount), allocation.indexType,
+        (void*)(allocation.firstWord * INDEX_WORD_SIZE), static_cast<GLsizei>(instanceCount), static_cast<GLint>(allocation.baseVertex));
+}
+
+void GeometryArena::draw(AllocationId id, const IndexPart& part, size_t instanceCount) {
+    const Allocation& allocation = allocations[id];
+    size_t offset = allocation.firstWord * INDEX_WORD_SIZE + part.firstIndex * getIndexSize(allocation.indexType);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(part.indexCount), allocation.indexType,
+        (void*)offset, static_cast<GLsizei>(instanceCount), static_cast<GLint>(allocation.baseVertex + part.baseVertex));
+}
+
+void GeometryArena::compact() {
+    for (size_t i = 0; i < pools.size(); ++i) {
+        const Pool& pool = pools[i];
+        if (needsCompaction(pool.vertices, INITIAL_VERTEX_CAPACITY) || needsCompaction(pool.indices, INITIAL_INDEX_CAPACITY)) {
+            relocate(i, getPackedCapacity(INITIAL_VERTEX_CAPACITY, pool.vertices.getUsedSize()),
+                getPackedCapacity(INITIAL_INDEX_CAPACITY, pool.indices.getUsedSize()));
+        }
+    }
+}
+
+size_t GeometryArena::getBufferMemory() {
+    size_t bytes = 0;
+    for (const Pool& pool : pools) {
+        bytes += pool.vertices.getCapacity() * getVertexStride(pool.format, pool.texCoords);
+        bytes += pool.indices.getCapacity() * INDEX_WORD_SIZE;
+    }
+    return bytes;
+}
+
+size_t GeometryArena::getPoolCount() {
+    size_t count = 0;
+    for (const Pool& pool : pools) {
+        if (pool.VAO != 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+size_t GeometryArena::getVertexStride(VertexFormat format, bool texCoords) {
+    if (format == VertexFormat_Compressed) {
+        return texCoords ? sizeof(CompressedVertex) : offsetof(CompressedVertex, texCoord);
+    }
+    return texCoords ? sizeof(FloatVertex) : offsetof(FloatVertex, texCoord);
+}
+
+size_t GeometryArena::getPoolIndex(VertexFormat format, bool texCoords) {
+    return static_cast<size_t>(format) * 2 + (texCoords ? 1 : 0);
+}
+
+void GeometryArena::relocate(size_t poolIndex, size_t vertexCapacity, size_t indexCapacity) {
+    Pool& pool = pools[poolIndex];
+    const size_t stride = getVertexStride(pool.format, pool.texCoords);
+
+    GLuint VBO = 0, EBO = 0;
+    if (vertexCapacity > 0 || indexCapacity > 0) {
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * stride, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+        glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * INDEX_WORD_SIZE, nullptr, GL_STATIC_DRAW);
+    }
+
+    // Copy the live ranges back to back, GPU to GPU
+    size_t vertexEnd = 0, indexEnd = 0;
+    for (Allocation& allocation : allocations) {
+        if (!allocation.live || allocation.pool != poolIndex) {
+            continue;
+        }
+        if (allocation.vertexCount > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, pool.VBO);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, allocation.baseVertex * stride, vertexEnd * stride, allocation.vertexCount * stride);
+        }
+        if (allocation.wordCount > 0) {
+            glBindBuffer(GL_COPY_READ_BUFFER, pool.EBO);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, allocation.firstWord * INDEX_WORD_SIZE, indexEnd * INDEX_WORD_SIZE, allocation.wordCount * INDEX_WORD_SIZE);
+        }
+        allocation.baseVertex = vertexEnd;
+        allocation.firstWord = indexEnd;
+        vertexEnd += allocation.vertexCount;
+        indexEnd += allocation.wordCount;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glDeleteBuffers(1, &pool.VBO);
+    glDeleteBuffers(1, &pool.EBO);
+    GpuMemory::untrack(pool.vertexMemoryId);
+    GpuMemory::untrack(pool.indexMemoryId);
+    pool.VBO = VBO;
+    pool.EBO = EBO;
+    pool.vertices.reset(vertexCapacity);
+    pool.indices.reset(indexCapacity);
+    size_t offset;
+    pool.vertices.allocate(vertexEnd, offset);
+    pool.indices.allocate(indexEnd, offset);
+
+    if (VBO == 0) {
+        GLState::forgetVertexArray(pool.VAO);
+        glDeleteVertexArrays(1, &pool.VAO);
+        pool.VAO = 0;
+        return;
+    }
+    if (pool.VAO == 0) {
+        glGenVertexArrays(1, &pool.VAO);
+    }
+    setupAttributes(pool);
+
+    const std::string layout = std::string(getVertexFormatName(pool.format)) + (pool.texCoords ? " + uv" : "");
+    pool.vertexMemoryId = GpuMemory::track(GpuMemoryCategory_Geometry, "arena " + layout + " vertices", layout, vertexCapacity * stride);
+    pool.indexMemoryId = GpuMemory::track(GpuMemoryCategory_Geometry, "arena " + layout + " indices", "16/32-bit indices",
+        indexCapacity * INDEX_WORD_SIZE);
+}
+
+void GeometryArena::setupAttributes(Pool& pool) {
+    const GLsizei stride = static_cast<GLsizei>(getVertexStride(pool.format, pool.texCoords));
+
+    GLState::bindVertexArray(pool.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, pool.VBO);
+    if (pool.format == VertexFormat_Compressed) {
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(CompressedVertex, position));
+        // Not normalized: the snorm conversion of GL 3.3 cannot represent 0, the shader divides by 127
+        glVertexAttribPointer(2, 2, GL_BYTE, GL_FALSE, stride, (void*)offsetof(CompressedVertex, normal));
+        if (pool.texCoords) {
+            glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(CompressedVertex, texCoord));
+        }
+    } else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(FloatVertex, position));
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(FloatVertex, normal));
+        if (pool.texCoords) {
+            glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(FloatVertex, texCoord));
+        }
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(2);
+    if (pool.texCoords) {
+        glEnableVertexAttribArray(1);
+    }
+    // The instance matrices are pointed at their buffer before every draw, see bindInstances()
+    for (GLuint location = INSTANCE_MODEL_ATTRIBUTE; location < INSTANCE_NORMAL_ATTRIBUTE + 3; ++location) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+    // The element buffer binding is part of the VAO
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.EBO);
+
+    GLState::bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
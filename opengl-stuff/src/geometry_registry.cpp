@@ -0,0 +1,121 @@
+#include "geometry_registry.h"
+
+#include <cstring>
+
+#include "hash.hpp"
+
+namespace {
+
+template <typename T>
+bool sameBytes(const std::vector<T>& a, const std::vector<T>& b) {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+}
+
+// Instantiate static variables
+std::unordered_map<uint64_t, GeometryRegistry::Entry> GeometryRegistry::geometries;
+size_t GeometryRegistry::reuseCount = 0;
+VertexFormat GeometryRegistry::vertexFormat = VertexFormat_Compressed;
+
+std::shared_ptr<Geometry> GeometryRegistry::acquire(const std::vector<glm::vec3>& vertices,
+    const std::vector<glm::vec2>& texCoords,
+    const std::vector<glm::vec3>& normals,
+    const std::vector<GLuint>& indices,
+    const std::vector<GLuint>& lodIndices,
+    const std::vector<GLuint>& lodIndexCounts) {
+
+    uint64_t hash = hashContent(vertices, texCoords, normals, indices, lodIndices, lodIndexCounts, vertexFormat);
+    uint64_t checksum = checksumContent(texCoords, normals, lodIndices, lodIndexCounts);
+    auto entryIt = geometries.find(hash);
+    if (entryIt != geometries.end()) {
+        const Entry& entry = entryIt->second;
+        std::shared_ptr<Geometry> geometry = entry.geometry.lock();
+        if (geometry && matches(entry, *geometry, vertices, indices, checksum, vertexFormat)) {
+            ++reuseCount;
+            return geometry;
+        }
+        // A collision between live geometries keeps the first one registered, the new one is not shared
+        if (geometry) {
+            return std::make_shared<Geometry>(vertices, texCoords, normals, indices, vertexFormat, lodIndices, lodIndexCounts);
+        }
+    }
+
+    // The entry is dropped together with the last reference to the geometry
+    std::shared_ptr<Geometry> geometry(new Geometry(vertices, texCoords, normals, indices, vertexFormat, lodIndices, lodIndexCounts), [hash](Geometry* released) {
+        auto releasedIt = geometries.find(hash);
+        if (releasedIt != geometries.end() && releasedIt->second.geometry.expired()) {
+            geometries.erase(releasedIt);
+        }
+        delete released;
+    });
+    geometries[hash] = { geometry, checksum, vertexFormat };
+    return geometry;
+}
+
+size_t GeometryRegistry::getGeometryCount() {
+    return geometries.size();
+}
+
+size_t GeometryRegistry::getReuseCount() {
+    return reuseCount;
+}
+
+size_t GeometryRegistry::getVertexMemory() {
+    size_t bytes = 0;
+    for (const auto& entry : geometries) {
+        std::shared_ptr<Geometry> geometry = entry.second.geometry.lock();
+        if (geometry) {
+            bytes += geometry->getVertexBufferSize();
+        }
+    }
+    return bytes;
+}
+
+void GeometryRegistry::setVertexFormat(VertexFormat format) {
+    vertexFormat = format;
+}
+
+VertexFormat GeometryRegistry::getVertexFormat() {
+    return vertexFormat;
+}
+
+bool GeometryRegistry::matches(const Entry& entry, Geometry& geometry,
+    const std::vector<glm::vec3>& vertices,
+    const std::vector<GLuint>& indices,
+    uint64_t checksum,
+    VertexFormat format) {
+
+    // Positions and indices are compared with the copy the geometry keeps for picking
+    return entry.format == format && entry.checksum == checksum
+        && sameBytes(geometry.getVertices(), vertices) && sameBytes(geometry.getIndices(), indices);
+}
+
+uint64_t GeometryRegistry::hashContent(const std::vector<glm::vec3>& vertices,
+    const std::vector<glm::vec2>& texCoords,
+    const std::vector<glm::vec3>& normals,
+    const std::vector<GLuint>& indices,
+    const std::vector<GLuint>& lodIndices,
+    const std::vector<GLuint>& lodIndexCounts,
+    VertexFormat format) {
+
+    // Each stream seeds the next one, the stream sizes are mixed in by hashBytes
+    uint64_t hash = hashBytes(&format, sizeof(format));
+    hash = hashBytes(vertices.data(), vertices.size() * sizeof(glm::vec3), hash);
+    hash = hashBytes(texCoords.data(), texCoords.size() * sizeof(glm::vec2), hash);
+    hash = hashBytes(normals.data(), normals.size() * sizeof(glm::vec3), hash);
+    hash = hashBytes(indices.data(), indices.size() * sizeof(GLuint), hash);
+    hash = hashBytes(lodIndices.data(), lodIndices.size() * sizeof(GLuint), hash);
+    return hashBytes(lodIndexCounts.data(), lodIndexCounts.size() * sizeof(GLuint), hash);
+}
+
+uint64_t GeometryRegistry::checksumContent(const std::vector<glm::vec2>& texCoords,
+    const std::vector<glm::vec3>& normals,
+    const std::vector<GLuint>& lodIndices,
+    const std::vector<GLuint>& lodIndexCounts) {
+
+    uint64_t checksum = checksumBytes(texCoords.data(), texCoords.size() * sizeof(glm::vec2));
+    checksum = checksumBytes(normals.data(), normals.size() * sizeof(glm::vec3), checksum);
+    checksum = checksumBytes(lodIndices.data(), lodIndices.size() * sizeof(GLuint), checksum);
+    return checksumBytes(lodIndexCounts.data(), lodIndexCounts.size() * sizeof(GLuint), checksum);
+}
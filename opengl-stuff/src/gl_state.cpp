@@ -0,0 +1,159 @@
+#include "gl_state.h"
+
+// Instantiate static variables
+GLuint  GLState::program = GLState::UNKNOWN;
+GLuint  GLState::vertexArray = GLState::UNKNOWN;
+GLuint  GLState::activeUnit = GLState::UNKNOWN;
+GLuint  GLState::textures[GLState::TEXTURE_UNITS] = {
+    UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
+    UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+GLuint  GLState::framebuffer = GLState::UNKNOWN;
+GLuint  GLState::blend = GLState::UNKNOWN;
+GLuint  GLState::blendSource = GLState::UNKNOWN;
+GLuint  GLState::blendDestination = GLState::UNKNOWN;
+GLuint  GLState::depthTest = GLState::UNKNOWN;
+GLuint  GLState::polygonModeState = GLState::UNKNOWN;
+size_t  GLState::issuedCalls = 0;
+size_t  GLState::elidedCalls = 0;
+size_t  GLState::lastIssuedCalls = 0;
+size_t  GLState::lastElidedCalls = 0;
+
+void GLState::useProgram(GLuint program) {
+    if (change(GLState::program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void GLState::bindVertexArray(GLuint vertexArray) {
+    if (change(GLState::vertexArray, vertexArray)) {
+        glBindVertexArray(vertexArray);
+    }
+}
+
+void GLState::activeTexture(GLuint unit) {
+    if (change(activeUnit, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
+
+void GLState::bindTexture(GLuint texture) {
+    if (activeUnit >= TEXTURE_UNITS) {
+        ++issuedCalls;
+        glBindTexture(GL_TEXTURE_2D, texture);
+        return;
+    }
+    if (change(textures[activeUnit], texture)) {
+        glBindTexture(GL_TEXTURE_2D, texture);
+    }
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer) {
+    if (change(GLState::framebuffer, framebuffer)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+}
+
+void GLState::setBlend(bool enabled) {
+    if (change(blend, enabled ? 1 : 0)) {
+        if (enabled) {
+            glEnable(GL_BLEND);
+        } else {
+            glDisable(GL_BLEND);
+        }
+    }
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination) {
+    if (source == blendSource && destination == blendDestination) {
+        ++elidedCalls;
+        return;
+    }
+    ++issuedCalls;
+    blendSource = source;
+    blendDestination = destination;
+    glBlendFunc(source, destination);
+}
+
+void GLState::setDepthTest(bool enabled) {
+    if (change(depthTest, enabled ? 1 : 0)) {
+        if (enabled) {
+            glEnable(GL_DEPTH_TEST);
+        } else {
+            glDisable(GL_DEPTH_TEST);
+        }
+    }
+}
+
+void GLState::polygonMode(GLenum mode) {
+    if (change(polygonModeState, mode)) {
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+    }
+}
+
+void GLState::forgetProgram(GLuint program) {
+    // A deleted program stays in use until another one is, the next use must reach the driver
+    if (GLState::program == program) {
+        GLState::program = UNKNOWN;
+    }
+}
+
+void GLState::forgetVertexArray(GLuint vertexArray) {
+    if (GLState::vertexArray == vertexArray) {
+        GLState::vertexArray = 0;
+    }
+}
+
+void GLState::forgetTexture(GLuint texture) {
+    for (GLuint& bound : textures) {
+        if (bound == texture) {
+            bound = 0;
+        }
+    }
+}
+
+void GLState::forgetFramebuffer(GLuint framebuffer) {
+    if (GLState::framebuffer == framebuffer) {
+        GLState::framebuffer = 0;
+    }
+}
+
+void GLState::invalidate() {
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    activeUnit = UNKNOWN;
+    for (GLuint& bound : textures) {
+        bound = UNKNOWN;
+    }
+    framebuffer = UNKNOWN;
+    blend = UNKNOWN;
+    blendSource = UNKNOWN;
+    blendDestination = UNKNOWN;
+    depthTest = UNKNOWN;
+    polygonModeState = UNKNOWN;
+}
+
+void GLState::endFrame() {
+    lastIssuedCalls = issuedCalls;
+    lastElidedCalls = elidedCalls;
+    issuedCalls = 0;
+    elidedCalls = 0;
+    invalidate();
+}
+
+size_t GLState::getIssuedCalls() {
+    return lastIssuedCalls;
+}
+
+size_t GLState::getElidedCalls() {
+    return lastElidedCalls;
+}
+
+bool GLState::change(GLuint& state, GLuint value) {
+    if (state == value) {
+        ++elidedCalls;
+        return false;
+    }
+    ++issuedCalls;
+    state = value;
+    return true;
+}
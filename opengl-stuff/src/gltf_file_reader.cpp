@@ -0,0 +1,743 @@
+#include "gltf_file_reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include "mapped_file.h"
+#include "resource_manager.h"
+#include "thread_pool.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+const uint32_t GLB_VERSION = 2;
+const uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+const uint32_t GLB_CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
+// Accessor component types and the triangle primitive mode, as numbered by the specification
+const int COMPONENT_BYTE = 5120;
+const int COMPONENT_UNSIGNED_BYTE = 5121;
+const int COMPONENT_SHORT = 5122;
+const int COMPONENT_UNSIGNED_SHORT = 5123;
+const int COMPONENT_UNSIGNED_INT = 5125;
+const int COMPONENT_FLOAT = 5126;
+const int MODE_TRIANGLES = 4;
+
+// A byte range inside a memory mapping or a decoded data: URI
+struct Span {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+// The parsed document and every byte range its accessors point into. Nothing is copied out of the
+// mappings, so the asset must outlive every Span taken from it.
+struct Asset {
+    MappedFile file;
+    std::vector<std::unique_ptr<MappedFile>> externalFiles;
+    std::vector<std::vector<unsigned char>> decodedBuffers;
+    std::vector<Span> buffers;
+    rapidjson::Document document;
+};
+
+// A validated accessor: count elements of components values each, stride bytes apart
+struct Accessor {
+    const unsigned char* data = nullptr;
+    size_t count = 0;
+    size_t stride = 0;
+    int componentType = 0;
+    int components = 0;
+    bool normalized = false;
+};
+
+// One primitive of a glTF mesh, converted once however many nodes reference its mesh
+struct Primitive {
+    unsigned int mesh;
+    unsigned int index;
+};
+
+inline uint32_t readUint32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Member lookup that never asserts on malformed files, nullptr when missing or of the wrong type
+const rapidjson::Value* findObject(const rapidjson::Value& object, const char* name) {
+    auto member = object.FindMember(name);
+    return member != object.MemberEnd() && member->value.IsObject() ? &member->value : nullptr;
+}
+
+const rapidjson::Value* findArray(const rapidjson::Value& object, const char* name) {
+    auto member = object.FindMember(name);
+    return member != object.MemberEnd() && member->value.IsArray() ? &member->value : nullptr;
+}
+
+const char* findString(const rapidjson::Value& object, const char* name) {
+    auto member = object.FindMember(name);
+    return member != object.MemberEnd() && member->value.IsString() ? member->value.GetString() : nullptr;
+}
+
+bool findUint(const rapidjson::Value& object, const char* name, uint64_t& out) {
+    auto member = object.FindMember(name);
+    if (member == object.MemberEnd() || !member->value.IsUint64()) {
+        return false;
+    }
+    out = member->value.GetUint64();
+    return true;
+}
+
+uint64_t getUint(const rapidjson::Value& object, const char* name, uint64_t fallback) {
+    uint64_t value;
+    return findUint(object, name, value) ? value : fallback;
+}
+
+float getFloat(const rapidjson::Value& object, const char* name, float fallback) {
+    auto member = object.FindMember(name);
+    return member != object.MemberEnd() && member->value.IsNumber() ? member->value.GetFloat() : fallback;
+}
+
+// Element index of an array member, nullptr when out of range or not an object
+const rapidjson::Value* getElement(const rapidjson::Value& document, const char* name, uint64_t index) {
+    const rapidjson::Value* array = findArray(document, name);
+    if (!array || index >= array->Size() || !(*array)[static_cast<rapidjson::SizeType>(index)].IsObject()) {
+        return nullptr;
+    }
+    return &(*array)[static_cast<rapidjson::SizeType>(index)];
+}
+
+// Reads up to count numbers of an array member into values, returns how many were read
+size_t readNumbers(const rapidjson::Value& object, const char* name, float* values, size_t count) {
+    const rapidjson::Value* array = findArray(object, name);
+    if (!array) {
+        return 0;
+    }
+    size_t read = 0;
+    for (; read < count && read < array->Size() && (*array)[static_cast<rapidjson::SizeType>(read)].IsNumber(); ++read) {
+        values[read] = (*array)[static_cast<rapidjson::SizeType>(read)].GetFloat();
+    }
+    return read;
+}
+
+int base64Value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '+' || c == '-') return 62;
+    if (c == '/' || c == '_') return 63;
+    return -1;
+}
+
+// Decodes a "data:<mime>;base64,<payload>" URI
+bool decodeDataUri(const char* uri, std::vector<unsigned char>& out) {
+    const char* payload = std::strstr(uri, ";base64,");
+    if (!payload) {
+        return false;
+    }
+    payload += std::strlen(";base64,");
+    size_t length = std::strlen(payload);
+    out.clear();
+    out.reserve(length / 4 * 3);
+    uint32_t bits = 0;
+    int bitCount = 0;
+    for (size_t i = 0; i < length && payload[i] != '='; ++i) {
+        int value = base64Value(payload[i]);
+        if (value < 0) {
+            return false;
+        }
+        bits = ((bits << 6) | static_cast<uint32_t>(value)) & 0xFFFFFF;
+        bitCount += 6;
+        if (bitCount >= 8) {
+            bitCount -= 8;
+            out.push_back(static_cast<unsigned char>(bits >> bitCount));
+        }
+    }
+    return true;
+}
+
+inline bool isDataUri(const char* uri) {
+    return std::strncmp(uri, "data:", 5) == 0;
+}
+
+// Undoes the percent-encoding of a relative URI, "my%20texture.png" becomes "my texture.png"
+std::string decodeUri(const char* uri) {
+    std::string path;
+    for (const char* p = uri; *p; ++p) {
+        if (*p == '%' && std::isxdigit(static_cast<unsigned char>(p[1])) && std::isxdigit(static_cast<unsigned char>(p[2]))) {
+            char hex[3] = { p[1], p[2], '\0' };
+            path.push_back(static_cast<char>(std::strtol(hex, nullptr, 16)));
+            p += 2;
+        } else {
+            path.push_back(*p);
+        }
+    }
+    return path;
+}
+
+// Parses the JSON of a .gltf file, or the chunks of a .glb file, the BIN chunk going to binChunk
+bool parseContainer(Asset& asset, Span& binChunk) {
+    const unsigned char* data = asset.file.data();
+    size_t size = asset.file.size();
+    if (size >= 12 && readUint32(data) == GLB_MAGIC) {
+        if (readUint32(data + 4) != GLB_VERSION || readUint32(data + 8) > size) {
+            return false;
+        }
+        size = readUint32(data + 8);
+        bool hasJson = false;
+        for (size_t offset = 12; offset + 8 <= size;) {
+            uint32_t length = readUint32(data + offset);
+            uint32_t type = readUint32(data + offset + 4);
+            offset += 8;
+            if (length > size - offset) {
+                return false;
+            }
+            if (type == GLB_CHUNK_JSON && !hasJson) {
+                asset.document.Parse(reinterpret_cast<const char*>(data + offset), length);
+                hasJson = true;
+            } else if (type == GLB_CHUNK_BIN && binChunk.data == nullptr) {
+                binChunk.data = data + offset;
+                binChunk.size = length;
+            }
+            offset += length;
+        }
+        if (!hasJson) {
+            return false;
+        }
+    } else {
+        asset.document.Parse(reinterpret_cast<const char*>(data), size);
+    }
+    return !asset.document.HasParseError() && asset.document.IsObject();
+}
+
+// Resolves every buffer to a byte range: the GLB BIN chunk, a decoded data: URI or a mapped file
+bool loadBuffers(Asset& asset, const std::string& filePath, const Span& binChunk) {
+    const rapidjson::Value* buffers = findArray(asset.document, "buffers");
+    if (!buffers) {
+        return true;
+    }
+    for (rapidjson::SizeType i = 0; i < buffers->Size(); ++i) {
+        const rapidjson::Value& buffer = (*buffers)[i];
+        uint64_t byteLength;
+        if (!buffer.IsObject() || !findUint(buffer, "byteLength", byteLength)) {
+            return false;
+        }
+        Span span;
+        const char* uri = findString(buffer, "uri");
+        if (!uri) {
+            if (i != 0 || binChunk.data == nullptr) {
+                return false;
+            }
+            span = binChunk;
+        } else if (isDataUri(uri)) {
+            asset.decodedBuffers.emplace_back();
+            if (!decodeDataUri(uri, asset.decodedBuffers.back())) {
+                return false;
+            }
+            span.data = asset.decodedBuffers.back().data();
+            span.size = asset.decodedBuffers.back().size();
+        } else {
+            std::string path = (fs::path(filePath).parent_path() / fs::u8path(decodeUri(uri))).string();
+            asset.externalFiles.push_back(std::make_unique<MappedFile>(path));
+            if (!asset.externalFiles.back()->isOpen()) {
+                std::cerr << "GltfFileReader: buffer not found: " << path << std::endl;
+                return false;
+            }
+            span.data = asset.externalFiles.back()->data();
+            span.size = asset.externalFiles.back()->size();
+        }
+        // The BIN chunk may be padded past byteLength, a shorter buffer is truncated
+        if (span.size < byteLength) {
+            return false;
+        }
+        span.size = static_cast<size_t>(byteLength);
+        asset.buffers.push_back(span);
+    }
+    return true;
+}
+
+bool getBufferView(const Asset& asset, uint64_t index, Span& span, size_t& byteStride) {
+    const rapidjson::Value* view = getElement(asset.document, "bufferViews", index);
+    uint64_t buffer, byteLength;
+    if (!view || !findUint(*view, "buffer", buffer) || !findUint(*view, "byteLength", byteLength) || buffer >= asset.buffers.size()) {
+        return false;
+    }
+    uint64_t byteOffset = getUint(*view, "byteOffset", 0);
+    const Span& bytes = asset.buffers[buffer];
+    if (byteOffset > bytes.size || byteLength > bytes.size - byteOffset) {
+        return false;
+    }
+    span.data = bytes.data + byteOffset;
+    span.size = static_cast<size_t>(byteLength);
+    byteStride = static_cast<size_t>(getUint(*view, "byteStride", 0));
+    return true;
+}
+
+int getComponentCount(const char* type) {
+    if (!type) return 0;
+    if (std::strcmp(type, "SCALAR") == 0) return 1;
+    if (std::strcmp(type, "VEC2") == 0) return 2;
+    if (std::strcmp(type, "VEC3") == 0) return 3;
+    if (std::strcmp(type, "VEC4") == 0) return 4;
+    return 0;
+}
+
+size_t getComponentSize(int componentType) {
+    switch (componentType) {
+    case COMPONENT_BYTE:
+    case COMPONENT_UNSIGNED_BYTE:
+        return 1;
+    case COMPONENT_SHORT:
+    case COMPONENT_UNSIGNED_SHORT:
+        return 2;
+    case COMPONENT_UNSIGNED_INT:
+    case COMPONENT_FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+// Checks that the whole accessor lies inside its buffer view. Sparse accessors and accessors
+// without a buffer view (all zeros) are not supported.
+bool getAccessor(const Asset& asset, uint64_t index, Accessor& accessor) {
+    const rapidjson::Value* value = getElement(asset.document, "accessors", index);
+    uint64_t bufferView, count, componentType;
+    if (!value || value->HasMember("sparse") || !findUint(*value, "bufferView", bufferView)
+        || !findUint(*value, "count", count) || !findUint(*value, "componentType", componentType)) {
+        return false;
+    }
+    accessor.componentType = static_cast<int>(componentType);
+    accessor.components = getComponentCount(findString(*value, "type"));
+    size_t elementSize = getComponentSize(accessor.componentType) * accessor.components;
+    if (elementSize == 0) {
+        return false;
+    }
+    auto normalized = value->FindMember("normalized");
+    accessor.normalized = normalized != value->MemberEnd() && normalized->value.IsBool() && normalized->value.GetBool();
+
+    Span view;
+    size_t byteStride;
+    if (!getBufferView(asset, bufferView, view, byteStride)) {
+        return false;
+    }
+    accessor.stride = byteStride != 0 ? byteStride : elementSize;
+    uint64_t byteOffset = getUint(*value, "byteOffset", 0);
+    if (accessor.stride < elementSize || byteOffset > view.size) {
+        return false;
+    }
+    if (count > 0 && (count - 1 > (view.size - byteOffset) / accessor.stride
+        || byteOffset + (count - 1) * accessor.stride + elementSize > view.size)) {
+        return false;
+    }
+    accessor.data = view.data + byteOffset;
+    accessor.count = static_cast<size_t>(count);
+    return true;
+}
+
+// Copies a float accessor into glm vectors, as one block when the elements are tightly packed
+template <typename Vector>
+bool readFloats(const Accessor& accessor, std::vector<Vector>& out) {
+    if (accessor.componentType != COMPONENT_FLOAT || accessor.components * sizeof(float) != sizeof(Vector)) {
+        return false;
+    }
+    out.resize(accessor.count);
+    if (accessor.stride == sizeof(Vector)) {
+        std::memcpy(out.data(), accessor.data, accessor.count * sizeof(Vector));
+    } else {
+        for (size_t i = 0; i < accessor.count; ++i) {
+            std::memcpy(&out[i], accessor.data + i * accessor.stride, sizeof(Vector));
+        }
+    }
+    return true;
+}
+
+// Texture coordinates are floats or normalized unsigned bytes/shorts
+bool readTexCoords(const Accessor& accessor, std::vector<glm::vec2>& out) {
+    if (accessor.componentType == COMPONENT_FLOAT) {
+        return readFloats(accessor, out);
+    }
+    if (accessor.components != 2 || !accessor.normalized) {
+        return false;
+    }
+    out.resize(accessor.count);
+    if (accessor.componentType == COMPONENT_UNSIGNED_BYTE) {
+        for (size_t i = 0; i < accessor.count; ++i) {
+            const unsigned char* element = accessor.data + i * accessor.stride;
+            out[i] = glm::vec2(element[0], element[1]) / 255.0f;
+        }
+        return true;
+    }
+    if (accessor.componentType == COMPONENT_UNSIGNED_SHORT) {
+        for (size_t i = 0; i < accessor.count; ++i) {
+            uint16_t element[2];
+            std::memcpy(element, accessor.data + i * accessor.stride, sizeof(element));
+            out[i] = glm::vec2(element[0], element[1]) / 65535.0f;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Widens the indices to GLuint, 32-bit tightly packed indices are copied as one block
+bool readIndices(const Accessor& accessor, std::vector<GLuint>& out) {
+    if (accessor.components != 1) {
+        return false;
+    }
+    out.resize(accessor.count);
+    if (accessor.componentType == COMPONENT_UNSIGNED_INT) {
+        if (accessor.stride == sizeof(GLuint)) {
+            std::memcpy(out.data(), accessor.data, accessor.count * sizeof(GLuint));
+        } else {
+            for (size_t i = 0; i < accessor.count; ++i) {
+                std::memcpy(&out[i], accessor.data + i * accessor.stride, sizeof(GLuint));
+            }
+        }
+    } else if (accessor.componentType == COMPONENT_UNSIGNED_SHORT) {
+        for (size_t i = 0; i < accessor.count; ++i) {
+            uint16_t index;
+            std::memcpy(&index, accessor.data + i * accessor.stride, sizeof(index));
+            out[i] = index;
+        }
+    } else if (accessor.componentType == COMPONENT_UNSIGNED_BYTE) {
+        for (size_t i = 0; i < accessor.count; ++i) {
+            out[i] = accessor.data[i * accessor.stride];
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Converts one triangle primitive, false when it is malformed
+bool convertPrimitive(const Asset& asset, const rapidjson::Value& primitive, MeshData& data) {
+    const rapidjson::Value* attributes = findObject(primitive, "attributes");
+    uint64_t position;
+    if (!attributes || !findUint(*attributes, "POSITION", position)) {
+        return false;
+    }
+    Accessor accessor;
+    if (!getAccessor(asset, position, accessor) || !readFloats(accessor, data.vertices)) {
+        return false;
+    }
+    const size_t vertexCount = data.vertices.size();
+
+    uint64_t normal;
+    if (findUint(*attributes, "NORMAL", normal)) {
+        if (!getAccessor(asset, normal, accessor) || accessor.count != vertexCount || !readFloats(accessor, data.normals)) {
+            return false;
+        }
+    } else {
+        data.normals.assign(vertexCount, glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    // Assimp flips glTF texture coordinates on import and aiProcess_FlipUVs flips them back, so they are kept as stored
+    uint64_t texCoord;
+    if (findUint(*attributes, "TEXCOORD_0", texCoord)) {
+        if (!getAccessor(asset, texCoord, accessor) || accessor.count != vertexCount || !readTexCoords(accessor, data.texCoords)) {
+            return false;
+        }
+    }
+
+    uint64_t indices;
+    if (findUint(primitive, "indices", indices)) {
+        if (!getAccessor(asset, indices, accessor) || !readIndices(accessor, data.indices)) {
+            return false;
+        }
+        for (GLuint index : data.indices) {
+            if (index >= vertexCount) {
+                return false;
+            }
+        }
+    } else {
+        data.indices.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            data.indices[i] = static_cast<GLuint>(i);
+        }
+    }
+    // Drop a trailing partial triangle rather than reading past the index buffer
+    data.indices.resize(data.indices.size() - data.indices.size() % 3);
+    return true;
+}
+
+// Lists the meshes referenced by the node hierarchy of the default scene, depth first like
+// ObjectReader::collectMeshes. Files without scenes list every mesh once.
+void collectMeshes(const rapidjson::Value& document, uint64_t node, std::vector<bool>& visited, std::vector<unsigned int>& meshes) {
+    const rapidjson::Value* value = getElement(document, "nodes", node);
+    if (!value || visited[node]) {
+        return;
+    }
+    visited[node] = true;
+    uint64_t mesh;
+    if (findUint(*value, "mesh", mesh)) {
+        meshes.push_back(static_cast<unsigned int>(mesh));
+    }
+    if (const rapidjson::Value* children = findArray(*value, "children")) {
+        for (const rapidjson::Value& child : children->GetArray()) {
+            if (child.IsUint()) {
+                collectMeshes(document, child.GetUint(), visited, meshes);
+            }
+        }
+    }
+}
+
+std::vector<unsigned int> collectMeshes(const rapidjson::Value& document) {
+    std::vector<unsigned int> meshes;
+    const rapidjson::Value* scene = getElement(document, "scenes", getUint(document, "scene", 0));
+    const rapidjson::Value* roots = scene ? findArray(*scene, "nodes") : nullptr;
+    if (roots) {
+        const rapidjson::Value* nodes = findArray(document, "nodes");
+        std::vector<bool> visited(nodes ? nodes->Size() : 0, false);
+        for (const rapidjson::Value& root : roots->GetArray()) {
+            if (root.IsUint()) {
+                collectMeshes(document, root.GetUint(), visited, meshes);
+            }
+        }
+    } else if (const rapidjson::Value* all = findArray(document, "meshes")) {
+        for (unsigned int i = 0; i < all->Size(); ++i) {
+            meshes.push_back(i);
+        }
+    }
+    return meshes;
+}
+
+// Converts a glTF material the way Assimp's importer and ObjectReader::readMaterial do: the base
+// color becomes the diffuse color and opacity, roughness becomes the shininess
+Material readMaterial(const Asset& asset, const rapidjson::Value& material, int& image) {
+    Material mat;
+    image = -1;
+    if (const rapidjson::Value* pbr = findObject(material, "pbrMetallicRoughness")) {
+        float baseColor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        readNumbers(*pbr, "baseColorFactor", baseColor, 4);
+        mat.diffuseColor = glm::vec3(baseColor[0], baseColor[1], baseColor[2]);
+        mat.opacity = baseColor[3];
+
+        float shininess = 1.0f - getFloat(*pbr, "roughnessFactor", 1.0f);
+        shininess *= shininess * 1000.0f;
+        mat.shininess = shininess == 0.0f ? 1.0f : shininess;
+
+        uint64_t texture, source;
+        const rapidjson::Value* baseColorTexture = findObject(*pbr, "baseColorTexture");
+        if (baseColorTexture && findUint(*baseColorTexture, "index", texture)) {
+            const rapidjson::Value* value = getElement(asset.document, "textures", texture);
+            if (value && findUint(*value, "source", source) && getElement(asset.document, "images", source)) {
+                image = static_cast<int>(source);
+            }
+        }
+    }
+    float emissive[3] = { 0.0f, 0.0f, 0.0f };
+    readNumbers(material, "emissiveFactor", emissive, 3);
+    mat.emissiveColor = glm::vec3(emissive[0], emissive[1], emissive[2]);
+    return mat;
+}
+
+// Name Assimp gives embedded textures, used as the key of the decoded image
+std::string getEmbeddedTextureName(int image) {
+    return "*" + std::to_string(image);
+}
+
+// Sets the texture path of the materials that have a texture and decodes the embedded images from
+// the mapping, external images are left to ObjectReader like the textures of every other format
+void readImages(const Asset& asset, const std::string& filePath, ModelData& model, const std::vector<int>& imageOfMaterial) {
+    std::vector<int> embedded;
+    for (size_t i = 0; i < imageOfMaterial.size(); ++i) {
+        int image = imageOfMaterial[i];
+        if (image < 0) {
+            continue;
+        }
+        const rapidjson::Value& value = *getElement(asset.document, "images", image);
+        const char* uri = findString(value, "uri");
+        if (uri && !isDataUri(uri)) {
+            model.materials[i].texturePath = decodeUri(uri);
+            continue;
+        }
+        model.materials[i].texturePath = getEmbeddedTextureName(image);
+        if (std::find(embedded.begin(), embedded.end(), image) == embedded.end()) {
+            embedded.push_back(image);
+            model.images[model.materials[i].texturePath] = ImageData();
+        }
+    }
+
+    ThreadPool::shared().parallelFor(embedded.size(), [&](size_t i) {
+        const rapidjson::Value& value = *getElement(asset.document, "images", embedded[i]);
+        ImageData& image = model.images.find(getEmbeddedTextureName(embedded[i]))->second;
+        const char* uri = findString(value, "uri");
+        uint64_t bufferView;
+        if (uri) {
+            std::vector<unsigned char> bytes;
+            if (decodeDataUri(uri, bytes)) {
+                image = ResourceManager::decodeImage(bytes.data(), bytes.size());
+            }
+        } else if (findUint(value, "bufferView", bufferView)) {
+            Span span;
+            size_t byteStride;
+            if (getBufferView(asset, bufferView, span, byteStride)) {
+                image = ResourceManager::decodeImage(span.data, span.size);
+            }
+        }
+        if (image.pixels == nullptr) {
+            std::cerr << "GltfFileReader: failed to decode image " << embedded[i] << " of " << filePath << std::endl;
+        }
+    });
+}
+
+bool hasGltfExtension(const std::string& filePath) {
+    std::string extension = fs::path(filePath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".gltf" || extension == ".glb";
+}
+
+}
+
+bool GltfFileReader::canRead(const std::string& filePath) {
+    return hasGltfExtension(filePath);
+}
+
+bool GltfFileReader::read(const std::string& filePath, ModelData& model, ImportListener* listener) {
+    Asset asset;
+    if (!asset.file.open(filePath)) {
+        std::cerr << "GltfFileReader: failed to open " << filePath << std::endl;
+        return false;
+    }
+    Span binChunk;
+    if (!parseContainer(asset, binChunk)) {
+        std::cerr << "GltfFileReader: malformed file " << filePath << std::endl;
+        return false;
+    }
+    const rapidjson::Value& document = asset.document;
+
+    // Compressed geometry (Draco, meshopt) and other required extensions are left to Assimp
+    if (const rapidjson::Value* required = findArray(document, "extensionsRequired")) {
+        if (!required->Empty()) {
+            std::cerr << "GltfFileReader: required extensions are not supported in " << filePath << std::endl;
+            return false;
+        }
+    }
+    if (!loadBuffers(asset, filePath, binChunk)) {
+        std::cerr << "GltfFileReader: malformed buffers in " << filePath << std::endl;
+        return false;
+    }
+
+    // Primitives of every referenced mesh, each converted once on the thread pool
+    std::vector<unsigned int> meshReferences = collectMeshes(document);
+    std::vector<unsigned int> meshes = meshReferences;
+    std::sort(meshes.begin(), meshes.end());
+    meshes.erase(std::unique(meshes.begin(), meshes.end()), meshes.end());
+    std::vector<Primitive> primitives;
+    std::vector<size_t> firstPrimitive;
+    std::vector<size_t> primitiveCount;
+    bool skipped = false;
+    for (unsigned int mesh : meshes) {
+        const rapidjson::Value* value = getElement(document, "meshes", mesh);
+        const rapidjson::Value* meshPrimitives = value ? findArray(*value, "primitives") : nullptr;
+        if (!meshPrimitives) {
+            std::cerr << "GltfFileReader: malformed mesh " << mesh << " in " << filePath << std::endl;
+            return false;
+        }
+        firstPrimitive.push_back(primitives.size());
+        for (unsigned int i = 0; i < meshPrimitives->Size(); ++i) {
+            const rapidjson::Value& primitive = (*meshPrimitives)[i];
+            // Points and lines are not drawn by the renderer, strips and fans are rare enough to leave out
+            if (!primitive.IsObject() || getUint(primitive, "mode", MODE_TRIANGLES) != MODE_TRIANGLES) {
+                skipped = true;
+                continue;
+            }
+            primitives.push_back({ mesh, i });
+        }
+        primitiveCount.push_back(primitives.size() - firstPrimitive.back());
+    }
+    if (skipped) {
+        std::cout << "GltfFileReader: skipped non-triangle primitives in " << filePath << std::endl;
+    }
+
+    std::vector<MeshData> converted(primitives.size());
+    std::atomic<bool> valid(true);
+    std::atomic<size_t> done(0);
+    ThreadPool::shared().parallelFor(primitives.size(), [&](size_t i) {
+        if (!valid || (listener && listener->isCancelled())) {
+            return;
+        }
+        const rapidjson::Value& mesh = *getElement(document, "meshes", primitives[i].mesh);
+        const rapidjson::Value& primitive = (*findArray(mesh, "primitives"))[primitives[i].index];
+        MeshData& data = converted[i];
+        if (!convertPrimitive(asset, primitive, data)) {
+            valid = false;
+            return;
+        }
+        const char* name = findString(mesh, "name");
+        data.name = name ? name : "mesh" + std::to_string(primitives[i].mesh);
+        if (findArray(mesh, "primitives")->Size() > 1) {
+            data.name += "-" + std::to_string(primitives[i].index);
+        }
+        uint64_t material;
+        data.materialIndex = findUint(primitive, "material", material) ? static_cast<unsigned int>(material) : UINT32_MAX;
+        if (listener) {
+            listener->onProgress(0.5f * static_cast<float>(++done) / primitives.size());
+        }
+    });
+    if (listener && listener->isCancelled()) {
+        return false;
+    }
+    if (!valid) {
+        std::cerr << "GltfFileReader: malformed primitive in " << filePath << std::endl;
+        return false;
+    }
+    if (primitives.empty()) {
+        std::cerr << "GltfFileReader: no triangles in " << filePath << std::endl;
+        return false;
+    }
+
+    // Materials, plus the default material Assimp appends for primitives without one
+    const rapidjson::Value emptyMaterial(rapidjson::kObjectType);
+    std::vector<int> imageOfMaterial;
+    if (const rapidjson::Value* materials = findArray(document, "materials")) {
+        for (const rapidjson::Value& material : materials->GetArray()) {
+            int image = -1;
+            model.materials.push_back(readMaterial(asset, material.IsObject() ? material : emptyMaterial, image));
+            imageOfMaterial.push_back(image);
+        }
+    }
+    const unsigned int defaultMaterial = static_cast<unsigned int>(model.materials.size());
+    bool usesDefaultMaterial = false;
+    for (MeshData& data : converted) {
+        if (data.materialIndex >= defaultMaterial) {
+            data.materialIndex = defaultMaterial;
+            usesDefaultMaterial = true;
+        }
+    }
+    if (usesDefaultMaterial) {
+        // the specification's default material, an empty material object
+        int image = -1;
+        model.materials.push_back(readMaterial(asset, emptyMaterial, image));
+        imageOfMaterial.push_back(image);
+    }
+    readImages(asset, filePath, model, imageOfMaterial);
+
+    // One mesh per reference in the hierarchy, the last reference takes the converted data
+    std::vector<size_t> remaining(meshes.size(), 0);
+    for (unsigned int mesh : meshReferences) {
+        ++remaining[std::lower_bound(meshes.begin(), meshes.end(), mesh) - meshes.begin()];
+    }
+    for (unsigned int mesh : meshReferences) {
+        size_t slot = std::lower_bound(meshes.begin(), meshes.end(), mesh) - meshes.begin();
+        bool last = --remaining[slot] == 0;
+        for (size_t i = firstPrimitive[slot]; i < firstPrimitive[slot] + primitiveCount[slot]; ++i) {
+            if (last) {
+                model.meshes.push_back(std::move(converted[i]));
+            } else {
+                model.meshes.push_back(converted[i]);
+            }
+        }
+    }
+    return true;
+}
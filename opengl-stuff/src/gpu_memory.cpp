@@ -0,0 +1,160 @@
+#include "gpu_memory.h"
+
+#include <algorithm>
+
+namespace {
+
+size_t getBytesPerPixel(GLenum internalFormat) {
+    switch (internalFormat) {
+    case GL_RED:
+    case GL_R8:
+        return 1;
+    case GL_RG:
+    case GL_RG8:
+    case GL_DEPTH_COMPONENT16:
+        return 2;
+    case GL_RGB:
+    case GL_RGB8:
+    case GL_DEPTH_COMPONENT24:
+        return 3;
+    case GL_RGBA16F:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        // GL_RGBA, GL_RGBA8, GL_DEPTH24_STENCIL8, GL_DEPTH_COMPONENT32F
+        return 4;
+    }
+}
+
+}
+
+// Instantiate static variables
+std::vector<GpuMemory::Entry>       GpuMemory::entries;
+std::vector<GpuMemory::ResourceId>  GpuMemory::freeIds;
+size_t                              GpuMemory::categoryBytes[GpuMemoryCategory_Count] = {};
+size_t                              GpuMemory::totalBytes = 0;
+size_t                              GpuMemory::peakBytes = 0;
+
+GpuMemory::ResourceId GpuMemory::track(GpuMemoryCategory category, const std::string& name, const std::string& format, size_t bytes) {
+    categoryBytes[category] += bytes;
+    totalBytes += bytes;
+    peakBytes = std::max(peakBytes, totalBytes);
+
+    Entry entry = { { category, name, format, bytes }, true };
+    if (!freeIds.empty()) {
+        ResourceId id = freeIds.back();
+        freeIds.pop_back();
+        entries[id] = entry;
+        return id;
+    }
+    entries.push_back(entry);
+    return entries.size() - 1;
+}
+
+void GpuMemory::untrack(ResourceId& id) {
+    if (id == NONE) {
+        return;
+    }
+    Entry& entry = entries[id];
+    categoryBytes[entry.resource.category] -= entry.resource.bytes;
+    totalBytes -= entry.resource.bytes;
+    entry.live = false;
+    entry.resource.name.clear();
+    freeIds.push_back(id);
+    id = NONE;
+}
+
+void GpuMemory::describe(ResourceId id, GpuMemoryCategory category, const std::string& name) {
+    if (id == NONE) {
+        return;
+    }
+    GpuResource& resource = entries[id].resource;
+    categoryBytes[resource.category] -= resource.bytes;
+    categoryBytes[category] += resource.bytes;
+    resource.category = category;
+    resource.name = name;
+}
+
+size_t GpuMemory::getTotalBytes() {
+    return totalBytes;
+}
+
+size_t GpuMemory::getPeakBytes() {
+    return peakBytes;
+}
+
+size_t GpuMemory::getCategoryBytes(GpuMemoryCategory category) {
+    return categoryBytes[category];
+}
+
+std::map<std::string, size_t> GpuMemory::getFormatBytes(GpuMemoryCategory category) {
+    std::map<std::string, size_t> formatBytes;
+    for (const Entry& entry : entries) {
+        if (entry.live && entry.resource.category == category) {
+            formatBytes[entry.resource.format] += entry.resource.bytes;
+        }
+    }
+    return formatBytes;
+}
+
+std::vector<GpuResource> GpuMemory::getLargestResources(size_t count) {
+    std::vector<const GpuResource*> live;
+    for (const Entry& entry : entries) {
+        if (entry.live) {
+            live.push_back(&entry.resource);
+        }
+    }
+    count = std::min(count, live.size());
+    std::partial_sort(live.begin(), live.begin() + count, live.end(),
+        [](const GpuResource* a, const GpuResource* b) { return a->bytes > b->bytes; });
+
+    std::vector<GpuResource> largest;
+    largest.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        largest.push_back(*live[i]);
+    }
+    return largest;
+}
+
+size_t GpuMemory::getTextureBytes(GLenum internalFormat, unsigned int width, unsigned int height, bool mipmapped) {
+    const size_t bytesPerPixel = getBytesPerPixel(internalFormat);
+    size_t bytes = static_cast<size_t>(width) * height * bytesPerPixel;
+    while (mipmapped && (width > 1 || height > 1)) {
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+        bytes += static_cast<size_t>(width) * height * bytesPerPixel;
+    }
+    return bytes;
+}
+
+const char* GpuMemory::getFormatName(GLenum internalFormat) {
+    switch (internalFormat) {
+    case GL_RED:
+    case GL_R8:
+        return "R8";
+    case GL_RG:
+    case GL_RG8:
+        return "RG8";
+    case GL_RGB:
+    case GL_RGB8:
+        return "RGB8";
+    case GL_RGBA:
+    case GL_RGBA8:
+        return "RGBA8";
+    case GL_RGBA16F:
+        return "RGBA16F";
+    case GL_RGBA32F:
+        return "RGBA32F";
+    case GL_DEPTH_COMPONENT16:
+        return "D16";
+    case GL_DEPTH_COMPONENT24:
+        return "D24";
+    case GL_DEPTH_COMPONENT32F:
+        return "D32F";
+    case GL_DEPTH24_STENCIL8:
+        return "D24S8";
+    default:
+        return "other";
+    }
+}
@@ -0,0 +1,101 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+    this->fileHandle = file;
+    this->length = static_cast<size_t>(fileSize.QuadPart);
+    this->opened = true;
+    // Empty files cannot be mapped, but are still valid
+    if (this->length == 0) {
+        return true;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        close();
+        return false;
+    }
+    this->mappingHandle = mapping;
+    this->bytes = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (this->bytes == nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (this->bytes != nullptr)
+        UnmapViewOfFile(this->bytes);
+    if (this->mappingHandle != nullptr)
+        CloseHandle(this->mappingHandle);
+    if (this->fileHandle != nullptr)
+        CloseHandle(this->fileHandle);
+    this->bytes = nullptr;
+    this->mappingHandle = nullptr;
+    this->fileHandle = nullptr;
+    this->length = 0;
+    this->opened = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        ::close(fd);
+        return false;
+    }
+    this->length = static_cast<size_t>(fileStat.st_size);
+    this->opened = true;
+    // Empty files cannot be mapped, but are still valid
+    if (this->length > 0) {
+        void* mapped = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(fd);
+            this->length = 0;
+            this->opened = false;
+            return false;
+        }
+        this->bytes = static_cast<const unsigned char*>(mapped);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (this->bytes != nullptr)
+        munmap(const_cast<unsigned char*>(this->bytes), this->length);
+    this->bytes = nullptr;
+    this->length = 0;
+    this->opened = false;
+}
+
+#endif
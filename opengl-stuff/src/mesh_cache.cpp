@@ -0,0 +1,398 @@
+#include "mesh_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "hash.hpp"
+#include "mapped_file.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char CACHE_MAGIC[8] = { 'M', 'D', 'L', 'C', 'A', 'C', 'H', 'E' };
+const uint32_t CACHE_VERSION = 7;
+// CacheMesh::flags
+const uint32_t CACHE_MESH_CLOSED = 1;
+const uint64_t CACHE_ALIGNMENT = 16;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t meshCount;
+    uint32_t materialCount;
+    uint32_t profile;
+    uint32_t dependencyCount;
+    uint32_t reserved;
+    uint64_t fileSize;      // size of the whole cache file, detects truncated writes
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t sourceHash;
+};
+
+struct CacheMesh {
+    uint64_t nameOffset;
+    uint64_t verticesOffset;
+    uint64_t texCoordsOffset;
+    uint64_t normalsOffset;
+    uint64_t indicesOffset;
+    uint64_t lodIndicesOffset;
+    uint64_t lodIndexCountsOffset;
+    uint64_t meshletsOffset;
+    uint32_t nameLength;
+    uint32_t vertexCount;
+    uint32_t texCoordCount;
+    uint32_t indexCount;
+    uint32_t lodIndexCount;
+    uint32_t lodCount;
+    uint32_t meshletCount;
+    uint32_t materialIndex;
+    uint32_t flags;
+};
+
+struct CacheMaterial {
+    float ambientColor[3];
+    float diffuseColor[3];
+    float specularColor[3];
+    float emissiveColor[3];
+    float shininess;
+    float opacity;
+    uint64_t texturePathOffset;
+    uint32_t texturePathLength;
+    uint32_t reserved;
+};
+
+// A file the model reads besides itself (an .mtl library of an .obj), checked like the model file
+struct CacheDependency {
+    uint64_t pathOffset;
+    uint32_t pathLength;
+    uint32_t reserved;
+    uint64_t size;          // MISSING_DEPENDENCY when the file did not exist
+    int64_t time;
+    uint64_t hash;
+};
+
+const uint64_t MISSING_DEPENDENCY = UINT64_MAX;
+
+struct SourceInfo {
+    uint64_t size;
+    int64_t time;
+};
+
+bool getSourceInfo(const std::string& path, SourceInfo& info) {
+    std::error_code error;
+    info.size = static_cast<uint64_t>(fs::file_size(path, error));
+    if (error)
+        return false;
+    info.time = static_cast<int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+    return !error;
+}
+
+bool hashSource(const std::string& path, uint64_t& hash) {
+    MappedFile source(path);
+    if (!source.isOpen())
+        return false;
+    hash = hashBytes(source.data(), source.size());
+    return true;
+}
+
+// Paths of the material libraries an .obj file names on its mtllib lines, relative to its folder,
+// in the same way ObjFileReader and Assimp resolve them
+std::vector<std::string> findDependencies(const std::string& modelPath) {
+    std::vector<std::string> dependencies;
+    std::string extension = fs::path(modelPath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension != ".obj")
+        return dependencies;
+    MappedFile source(modelPath);
+    if (!source.isOpen())
+        return dependencies;
+    const char* p = reinterpret_cast<const char*>(source.data());
+    const char* end = p + source.size();
+    auto isBlank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (lineEnd == nullptr)
+            lineEnd = end;
+        if (lineEnd - p > 6 && std::memcmp(p, "mtllib", 6) == 0 && isBlank(p[6])) {
+            const char* first = p + 6;
+            const char* last = lineEnd;
+            while (first < last && isBlank(*first))
+                ++first;
+            while (last > first && isBlank(last[-1]))
+                --last;
+            std::string path = (fs::path(modelPath).parent_path() / std::string(first, last)).string();
+            if (first < last && std::find(dependencies.begin(), dependencies.end(), path) == dependencies.end())
+                dependencies.push_back(path);
+        }
+        p = lineEnd + 1;
+    }
+    return dependencies;
+}
+
+// Appends raw bytes to the blob area and returns their offset
+uint64_t appendBlob(std::vector<unsigned char>& buffer, const void* data, size_t size) {
+    size_t offset = (buffer.size() + CACHE_ALIGNMENT - 1) / CACHE_ALIGNMENT * CACHE_ALIGNMENT;
+    buffer.resize(offset + size);
+    if (size > 0)
+        std::memcpy(buffer.data() + offset, data, size);
+    return offset;
+}
+
+template <typename T>
+bool readArray(const MappedFile& file, uint64_t offset, uint32_t count, std::vector<T>& out) {
+    uint64_t size = static_cast<uint64_t>(count) * sizeof(T);
+    if (offset > file.size() || size > file.size() - offset)
+        return false;
+    out.resize(count);
+    if (count > 0)
+        std::memcpy(out.data(), file.data() + offset, size);
+    return true;
+}
+
+bool readString(const MappedFile& file, uint64_t offset, uint32_t length, std::string& out) {
+    if (offset > file.size() || length > file.size() - offset)
+        return false;
+    out.assign(reinterpret_cast<const char*>(file.data() + offset), length);
+    return true;
+}
+
+}
+
+// Instantiate static variables
+bool MeshCache::enabled = true;
+
+void MeshCache::setEnabled(bool enabled) {
+    MeshCache::enabled = enabled;
+}
+
+bool MeshCache::isEnabled() {
+    return enabled;
+}
+
+std::string MeshCache::getCachePath(const std::string& modelPath, ImportProfile profile) {
+    return modelPath + "." + getImportProfileName(profile) + ".meshcache";
+}
+
+bool MeshCache::load(const std::string& modelPath, ImportProfile profile, ModelData& model) {
+    if (!enabled)
+        return false;
+    std::string cachePath = getCachePath(modelPath, profile);
+    SourceInfo source;
+    if (!getSourceInfo(modelPath, source))
+        return false;
+    MappedFile file(cachePath);
+    if (!file.isOpen() || file.size() < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION
+        || header.profile != static_cast<uint32_t>(profile) || header.fileSize != file.size())
+        return false;
+    if (header.sourceSize != source.size)
+        return false;
+    // A different modification time alone does not invalidate the cache (e.g. a fresh checkout),
+    // the content hash decides. The new time is stored so the next load takes the fast path.
+    bool touched = header.sourceTime != source.time;
+    if (touched) {
+        uint64_t sourceHash;
+        if (!hashSource(modelPath, sourceHash) || sourceHash != header.sourceHash)
+            return false;
+    }
+
+    uint64_t tablesSize = sizeof(CacheHeader) + static_cast<uint64_t>(header.meshCount) * sizeof(CacheMesh) + static_cast<uint64_t>(header.materialCount) * sizeof(CacheMaterial)
+        + static_cast<uint64_t>(header.dependencyCount) * sizeof(CacheDependency);
+    if (tablesSize > file.size())
+        return false;
+    const unsigned char* meshTable = file.data() + sizeof(CacheHeader);
+    const unsigned char* materialTable = meshTable + header.meshCount * sizeof(CacheMesh);
+    const uint64_t dependencyTableOffset = tablesSize - static_cast<uint64_t>(header.dependencyCount) * sizeof(CacheDependency);
+    const unsigned char* dependencyTable = file.data() + dependencyTableOffset;
+
+    // The material libraries are checked like the model file, edited ones invalidate the cache
+    std::vector<CacheDependency> dependencies(header.dependencyCount);
+    bool dependenciesTouched = false;
+    for (uint32_t i = 0; i < header.dependencyCount; ++i) {
+        CacheDependency& record = dependencies[i];
+        std::memcpy(&record, dependencyTable + i * sizeof(CacheDependency), sizeof(record));
+        std::string path;
+        if (!readString(file, record.pathOffset, record.pathLength, path))
+            return false;
+        SourceInfo dependency;
+        if (!getSourceInfo(path, dependency)) {
+            if (record.size == MISSING_DEPENDENCY)
+                continue;
+            return false;
+        }
+        if (record.size != dependency.size)
+            return false;
+        if (record.time != dependency.time) {
+            uint64_t dependencyHash;
+            if (!hashSource(path, dependencyHash) || dependencyHash != record.hash)
+                return false;
+            record.time = dependency.time;
+            dependenciesTouched = true;
+        }
+    }
+
+    ModelData cached;
+    cached.meshes.resize(header.meshCount);
+    for (uint32_t i = 0; i < header.meshCount; ++i) {
+        CacheMesh record;
+        std::memcpy(&record, meshTable + i * sizeof(CacheMesh), sizeof(record));
+        MeshData& mesh = cached.meshes[i];
+        mesh.materialIndex = record.materialIndex;
+        mesh.closed = (record.flags & CACHE_MESH_CLOSED) != 0;
+        if (!readString(file, record.nameOffset, record.nameLength, mesh.name)
+            || !readArray(file, record.verticesOffset, record.vertexCount, mesh.vertices)
+            || !readArray(file, record.texCoordsOffset, record.texCoordCount, mesh.texCoords)
+            || !readArray(file, record.normalsOffset, record.vertexCount, mesh.normals)
+            || !readArray(file, record.indicesOffset, record.indexCount, mesh.indices)
+            || !readArray(file, record.lodIndicesOffset, record.lodIndexCount, mesh.lodIndices)
+            || !readArray(file, record.lodIndexCountsOffset, record.lodCount, mesh.lodIndexCounts)
+            || !readArray(file, record.meshletsOffset, record.meshletCount, mesh.meshlets))
+            return false;
+    }
+    cached.materials.resize(header.materialCount);
+    for (uint32_t i = 0; i < header.materialCount; ++i) {
+        CacheMaterial record;
+        std::memcpy(&record, materialTable + i * sizeof(CacheMaterial), sizeof(record));
+        Material& material = cached.materials[i];
+        material.ambientColor = glm::vec3(record.ambientColor[0], record.ambientColor[1], record.ambientColor[2]);
+        material.diffuseColor = glm::vec3(record.diffuseColor[0], record.diffuseColor[1], record.diffuseColor[2]);
+        material.specularColor = glm::vec3(record.specularColor[0], record.specularColor[1], record.specularColor[2]);
+        material.emissiveColor = glm::vec3(record.emissiveColor[0], record.emissiveColor[1], record.emissiveColor[2]);
+        material.shininess = record.shininess;
+        material.opacity = record.opacity;
+        if (!readString(file, record.texturePathOffset, record.texturePathLength, material.texturePath))
+            return false;
+    }
+    file.close();
+
+    if (touched || dependenciesTouched) {
+        header.sourceTime = source.time;
+        std::fstream out(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.seekp(static_cast<std::streamoff>(dependencyTableOffset));
+        if (!dependencies.empty())
+            out.write(reinterpret_cast<const char*>(dependencies.data()), dependencies.size() * sizeof(CacheDependency));
+    }
+
+    model = std::move(cached);
+    return true;
+}
+
+bool MeshCache::save(const std::string& modelPath, ImportProfile profile, const ModelData& model) {
+    if (!enabled)
+        return false;
+    SourceInfo source;
+    CacheHeader header = {};
+    if (!getSourceInfo(modelPath, source) || !hashSource(modelPath, header.sourceHash))
+        return false;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.profile = static_cast<uint32_t>(profile);
+    header.meshCount = static_cast<uint32_t>(model.meshes.size());
+    header.materialCount = static_cast<uint32_t>(model.materials.size());
+    header.sourceSize = source.size;
+    header.sourceTime = source.time;
+    std::vector<std::string> dependencyPaths = findDependencies(modelPath);
+    header.dependencyCount = static_cast<uint32_t>(dependencyPaths.size());
+
+    // Tables go first, the blobs they point to are appended after them
+    std::vector<unsigned char> buffer(sizeof(CacheHeader) + model.meshes.size() * sizeof(CacheMesh) + model.materials.size() * sizeof(CacheMaterial)
+        + dependencyPaths.size() * sizeof(CacheDependency));
+    std::vector<CacheMesh> meshRecords(model.meshes.size());
+    for (size_t i = 0; i < model.meshes.size(); ++i) {
+        const MeshData& mesh = model.meshes[i];
+        CacheMesh& record = meshRecords[i];
+        record = {};
+        record.nameLength = static_cast<uint32_t>(mesh.name.size());
+        record.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        record.texCoordCount = static_cast<uint32_t>(mesh.texCoords.size());
+        record.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        record.lodIndexCount = static_cast<uint32_t>(mesh.lodIndices.size());
+        record.lodCount = static_cast<uint32_t>(mesh.lodIndexCounts.size());
+        record.meshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+        record.materialIndex = mesh.materialIndex;
+        record.flags = mesh.closed ? CACHE_MESH_CLOSED : 0;
+        record.nameOffset = appendBlob(buffer, mesh.name.data(), mesh.name.size());
+        record.verticesOffset = appendBlob(buffer, mesh.vertices.data(), mesh.vertices.size() * sizeof(glm::vec3));
+        record.texCoordsOffset = appendBlob(buffer, mesh.texCoords.data(), mesh.texCoords.size() * sizeof(glm::vec2));
+        record.normalsOffset = appendBlob(buffer, mesh.normals.data(), mesh.normals.size() * sizeof(glm::vec3));
+        record.indicesOffset = appendBlob(buffer, mesh.indices.data(), mesh.indices.size() * sizeof(GLuint));
+        record.lodIndicesOffset = appendBlob(buffer, mesh.lodIndices.data(), mesh.lodIndices.size() * sizeof(GLuint));
+        record.lodIndexCountsOffset = appendBlob(buffer, mesh.lodIndexCounts.data(), mesh.lodIndexCounts.size() * sizeof(GLuint));
+        record.meshletsOffset = appendBlob(buffer, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+    }
+    std::vector<CacheMaterial> materialRecords(model.materials.size());
+    for (size_t i = 0; i < model.materials.size(); ++i) {
+        const Material& material = model.materials[i];
+        CacheMaterial& record = materialRecords[i];
+        record = {};
+        std::memcpy(record.ambientColor, &material.ambientColor, sizeof(record.ambientColor));
+        std::memcpy(record.diffuseColor, &material.diffuseColor, sizeof(record.diffuseColor));
+        std::memcpy(record.specularColor, &material.specularColor, sizeof(record.specularColor));
+        std::memcpy(record.emissiveColor, &material.emissiveColor, sizeof(record.emissiveColor));
+        record.shininess = material.shininess;
+        record.opacity = material.opacity;
+        record.texturePathLength = static_cast<uint32_t>(material.texturePath.size());
+        record.texturePathOffset = appendBlob(buffer, material.texturePath.data(), material.texturePath.size());
+    }
+    std::vector<CacheDependency> dependencyRecords(dependencyPaths.size());
+    for (size_t i = 0; i < dependencyPaths.size(); ++i) {
+        const std::string& path = dependencyPaths[i];
+        CacheDependency& record = dependencyRecords[i];
+        record = {};
+        SourceInfo dependency;
+        if (getSourceInfo(path, dependency)) {
+            if (!hashSource(path, record.hash))
+                return false;
+            record.size = dependency.size;
+            record.time = dependency.time;
+        } else {
+            record.size = MISSING_DEPENDENCY;
+        }
+        record.pathLength = static_cast<uint32_t>(path.size());
+        record.pathOffset = appendBlob(buffer, path.data(), path.size());
+    }
+    header.fileSize = buffer.size();
+
+    unsigned char* tables = buffer.data();
+    std::memcpy(tables, &header, sizeof(header));
+    tables += sizeof(header);
+    if (!meshRecords.empty())
+        std::memcpy(tables, meshRecords.data(), meshRecords.size() * sizeof(CacheMesh));
+    tables += meshRecords.size() * sizeof(CacheMesh);
+    if (!materialRecords.empty())
+        std::memcpy(tables, materialRecords.data(), materialRecords.size() * sizeof(CacheMaterial));
+    tables += materialRecords.size() * sizeof(CacheMaterial);
+    if (!dependencyRecords.empty())
+        std::memcpy(tables, dependencyRecords.data(), dependencyRecords.size() * sizeof(CacheDependency));
+
+    // Write to a temporary file first so a half written cache is never picked up
+    std::string cachePath = getCachePath(modelPath, profile);
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        if (!out) {
+            std::cerr << "Failed to write mesh cache " << tempPath << std::endl;
+            return false;
+        }
+    }
+    std::error_code error;
+    fs::rename(tempPath, cachePath, error);
+    if (error) {
+        std::cerr << "Failed to write mesh cache " << cachePath << ": " << error.message() << std::endl;
+        fs::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
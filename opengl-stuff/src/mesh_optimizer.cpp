@@ -0,0 +1,855 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <glm/glm.hpp>
+
+namespace {
+
+// A cluster is closed once its own ACMR gets this close to the ACMR of the whole mesh: splitting it
+// further would cost cache misses, while longer clusters leave the overdraw pass less to sort
+const float CLUSTER_ACMR_THRESHOLD = 1.05f;
+
+// Every LOD level aims for half the triangles of the previous one, within an error budget that
+// starts at half a percent of the mesh size and doubles per level
+const float LOD_TRIANGLE_RATIO = 0.5f;
+const float LOD_BASE_ERROR = 0.005f;
+// A level is dropped (and the chain ends) when it keeps more than this share of the previous
+// level's triangles, which happens once locked borders and seams are all that is left
+const float LOD_MIN_REDUCTION = 0.8f;
+const size_t MIN_LOD_TRIANGLES = 64;
+
+// Past this many triangles a meshlet only grows with triangles whose normal is within
+// MESHLET_NORMAL_LIMIT (a cosine) of the meshlet's average normal, which keeps its cone narrow
+const size_t MESHLET_MIN_TRIANGLES = 64;
+const float MESHLET_NORMAL_LIMIT = 0.7f;
+// A normal cone whose normals get closer than this to perpendicular to its axis is never culled
+const float MESHLET_MIN_CONE_DOT = 0.1f;
+
+// FIFO post-transform cache. A vertex is cached while fewer than size misses happened since it was
+// loaded, so flushing only has to move the clock forward.
+struct FifoCache {
+    std::vector<uint32_t> timestamps;
+    uint32_t time;
+    unsigned int size;
+
+    FifoCache(size_t vertexCount, unsigned int size) : timestamps(vertexCount, 0), time(size + 1), size(size) { }
+
+    // returns true on a miss
+    bool access(GLuint vertex) {
+        if (time - timestamps[vertex] <= size) {
+            return false;
+        }
+        timestamps[vertex] = time++;
+        return true;
+    }
+
+    void flush() {
+        time += size + 1;
+    }
+};
+
+// Pops the dead-end stack for a vertex that still has triangles, then falls back to the next such
+// vertex in input order. Returns -1 once every triangle has been emitted.
+int64_t skipDeadEnd(std::vector<GLuint>& deadEnd, const std::vector<uint32_t>& liveCount, size_t& cursor) {
+    while (!deadEnd.empty()) {
+        GLuint vertex = deadEnd.back();
+        deadEnd.pop_back();
+        if (liveCount[vertex] > 0) {
+            return vertex;
+        }
+    }
+    for (; cursor < liveCount.size(); ++cursor) {
+        if (liveCount[cursor] > 0) {
+            return static_cast<int64_t>(cursor);
+        }
+    }
+    return -1;
+}
+
+// Tipsify: fans out around one vertex at a time, emitting all its remaining triangles, then moves
+// to the neighbour that is still in the cache and has the fewest triangles left. hardBoundaries
+// receives the triangle each jump to an unrelated vertex starts at, the cache is cold there.
+std::vector<GLuint> optimizeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, unsigned int cacheSize,
+    std::vector<size_t>& hardBoundaries) {
+
+    const size_t triangleCount = indices.size() / 3;
+
+    // Triangles around each vertex
+    std::vector<uint32_t> liveCount(vertexCount, 0);
+    for (GLuint vertex : indices) {
+        ++liveCount[vertex];
+    }
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        offsets[i + 1] = offsets[i] + liveCount[i];
+    }
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<GLuint> deadEnd;
+    std::vector<GLuint> candidates;
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    deadEnd.reserve(indices.size());
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0;
+
+    int64_t fanning = skipDeadEnd(deadEnd, liveCount, cursor);
+    hardBoundaries.push_back(0);
+    while (fanning >= 0) {
+        candidates.clear();
+        for (uint32_t k = offsets[fanning]; k < offsets[fanning + 1]; ++k) {
+            uint32_t triangle = adjacency[k];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (size_t corner = 0; corner < 3; ++corner) {
+                GLuint vertex = indices[triangle * 3 + corner];
+                result.push_back(vertex);
+                deadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveCount[vertex];
+                if (time - cacheTime[vertex] > cacheSize) {
+                    cacheTime[vertex] = time++;
+                }
+            }
+            emitted[triangle] = 1;
+        }
+
+        // Prefer the candidate that entered the cache first, as long as fanning it out will not
+        // push it out of the cache; the others get priority 0
+        int64_t next = -1;
+        int64_t bestPriority = -1;
+        for (GLuint vertex : candidates) {
+            if (liveCount[vertex] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cacheTime[vertex] + 2 * liveCount[vertex] <= cacheSize) {
+                priority = time - cacheTime[vertex];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = vertex;
+            }
+        }
+        if (next < 0) {
+            next = skipDeadEnd(deadEnd, liveCount, cursor);
+            if (next >= 0) {
+                hardBoundaries.push_back(result.size() / 3);
+            }
+        }
+        fanning = next;
+    }
+    return result;
+}
+
+// Sorts the clusters of a cache-ordered triangle list front to back, roughly: clusters whose
+// surface faces away from the mesh centroid are on the outside and are drawn first
+std::vector<GLuint> optimizeOverdraw(const std::vector<GLuint>& indices, const std::vector<glm::vec3>& positions,
+    const std::vector<size_t>& hardBoundaries, unsigned int cacheSize) {
+
+    const size_t triangleCount = indices.size() / 3;
+    const float meshACMR = MeshOptimizer::analyzeVertexCache(indices, positions.size(), cacheSize).getACMR();
+
+    // Cut the hard clusters further wherever the cache would start over at little cost
+    std::vector<size_t> clusters;
+    FifoCache cache(positions.size(), cacheSize);
+    for (size_t h = 0; h < hardBoundaries.size(); ++h) {
+        size_t start = hardBoundaries[h];
+        size_t end = h + 1 < hardBoundaries.size() ? hardBoundaries[h + 1] : triangleCount;
+        size_t clusterStart = start;
+        size_t misses = 0;
+        cache.flush();
+        clusters.push_back(start);
+        for (size_t t = start; t < end; ++t) {
+            for (size_t corner = 0; corner < 3; ++corner) {
+                misses += cache.access(indices[t * 3 + corner]) ? 1 : 0;
+            }
+            float clusterACMR = static_cast<float>(misses) / (t + 1 - clusterStart);
+            if (t + 1 < end && clusterACMR <= meshACMR * CLUSTER_ACMR_THRESHOLD) {
+                clusterStart = t + 1;
+                misses = 0;
+                cache.flush();
+                clusters.push_back(clusterStart);
+            }
+        }
+    }
+
+    // Area weighted centroid and normal of each cluster
+    struct Cluster {
+        size_t start;
+        size_t end;
+        float sortKey;
+    };
+    std::vector<Cluster> sorted(clusters.size());
+    std::vector<glm::vec3> centroids(clusters.size());
+    std::vector<glm::vec3> normals(clusters.size());
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        sorted[c].start = clusters[c];
+        sorted[c].end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        glm::vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = sorted[c].start; t < sorted[c].end; ++t) {
+            const glm::vec3& a = positions[indices[t * 3]];
+            const glm::vec3& b = positions[indices[t * 3 + 1]];
+            const glm::vec3& p = positions[indices[t * 3 + 2]];
+            glm::vec3 cross = glm::cross(b - a, p - a);
+            float triangleArea = glm::length(cross);
+            centroid += (a + b + p) * (triangleArea / 3.0f);
+            normal += cross;
+            area += triangleArea;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        centroids[c] = area > 0.0f ? centroid / area : centroid;
+        float normalLength = glm::length(normal);
+        normals[c] = normalLength > 0.0f ? normal / normalLength : normal;
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+    for (size_t c = 0; c < sorted.size(); ++c) {
+        sorted[c].sortKey = glm::dot(centroids[c] - meshCentroid, normals[c]);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    for (const Cluster& cluster : sorted) {
+        result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+    }
+    return result;
+}
+
+// Symmetric 4x4 error quadric (Garland and Heckbert) of the planes around a vertex. The plane
+// weights are summed as well, so the error is a mean squared distance and does not grow with the
+// number of triangles merged into a vertex.
+struct Quadric {
+    double xx = 0.0, xy = 0.0, xz = 0.0, xw = 0.0;
+    double yy = 0.0, yz = 0.0, yw = 0.0;
+    double zz = 0.0, zw = 0.0;
+    double ww = 0.0;
+    double weight = 0.0;
+
+    void addPlane(const glm::dvec3& normal, double distance, double planeWeight) {
+        xx += planeWeight * normal.x * normal.x;
+        xy += planeWeight * normal.x * normal.y;
+        xz += planeWeight * normal.x * normal.z;
+        xw += planeWeight * normal.x * distance;
+        yy += planeWeight * normal.y * normal.y;
+        yz += planeWeight * normal.y * normal.z;
+        yw += planeWeight * normal.y * distance;
+        zz += planeWeight * normal.z * normal.z;
+        zw += planeWeight * normal.z * distance;
+        ww += planeWeight * distance * distance;
+        weight += planeWeight;
+    }
+
+    void add(const Quadric& other) {
+        xx += other.xx; xy += other.xy; xz += other.xz; xw += other.xw;
+        yy += other.yy; yz += other.yz; yw += other.yw;
+        zz += other.zz; zw += other.zw;
+        ww += other.ww;
+        weight += other.weight;
+    }
+
+    double getError(const glm::dvec3& p) const {
+        double error = xx * p.x * p.x + 2.0 * xy * p.x * p.y + 2.0 * xz * p.x * p.z + 2.0 * xw * p.x
+            + yy * p.y * p.y + 2.0 * yz * p.y * p.z + 2.0 * yw * p.y
+            + zz * p.z * p.z + 2.0 * zw * p.z
+            + ww;
+        return weight > 0.0 ? std::abs(error) / weight : 0.0;
+    }
+};
+
+struct Collapse {
+    GLuint from;
+    GLuint to;
+    double error;
+};
+
+// Triangles around each vertex, as offsets into adjacency
+void buildAdjacency(const std::vector<GLuint>& indices, size_t vertexCount, std::vector<uint32_t>& offsets, std::vector<uint32_t>& adjacency) {
+    offsets.assign(vertexCount + 1, 0);
+    for (GLuint vertex : indices) {
+        ++offsets[vertex + 1];
+    }
+    for (size_t i = 0; i < vertexCount; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    adjacency.resize(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i) {
+        adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+}
+
+// Maps every vertex to the first vertex at the same position, so the topology is followed across
+// seams where normals or texture coordinates differ
+std::vector<GLuint> findCanonicalVertices(const std::vector<glm::vec3>& vertices) {
+    std::vector<GLuint> order(vertices.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto less = [&](GLuint a, GLuint b) {
+        const glm::vec3& p = vertices[a];
+        const glm::vec3& q = vertices[b];
+        if (p.x != q.x) return p.x < q.x;
+        if (p.y != q.y) return p.y < q.y;
+        if (p.z != q.z) return p.z < q.z;
+        return a < b;
+    };
+    std::sort(order.begin(), order.end(), less);
+    std::vector<GLuint> canonical(vertices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        bool samePosition = i > 0 && vertices[order[i]] == vertices[order[i - 1]];
+        canonical[order[i]] = samePosition ? canonical[order[i - 1]] : order[i];
+    }
+    return canonical;
+}
+
+// Whether the triangles (given by canonical position indices) enclose a volume: every edge is used
+// once in each direction, so no back face can ever be seen from outside. Degenerate edges are ignored.
+bool isClosedSurface(const std::vector<GLuint>& positionIndices) {
+    std::vector<uint64_t> edges;
+    edges.reserve(positionIndices.size());
+    for (size_t t = 0; t + 2 < positionIndices.size(); t += 3) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            GLuint from = positionIndices[t + corner];
+            GLuint to = positionIndices[t + (corner + 1) % 3];
+            if (from != to) {
+                edges.push_back(static_cast<uint64_t>(from) << 32 | to);
+            }
+        }
+    }
+    if (edges.empty()) {
+        return false;
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size(); ) {
+        size_t end = i + 1;
+        while (end < edges.size() && edges[end] == edges[i]) {
+            ++end;
+        }
+        uint64_t reverse = (edges[i] & 0xFFFFFFFF) << 32 | edges[i] >> 32;
+        auto range = std::equal_range(edges.begin(), edges.end(), reverse);
+        if (static_cast<size_t>(range.second - range.first) != end - i) {
+            return false;
+        }
+        i = end;
+    }
+    return true;
+}
+
+// Vertices that must not move: borders and non-manifold edges (edges not shared by exactly two
+// triangles) and attribute seams (several referenced vertices at one position)
+std::vector<char> findLockedVertices(const std::vector<GLuint>& indices, const std::vector<GLuint>& canonical) {
+    const size_t vertexCount = canonical.size();
+    std::vector<char> lockedCanonical(vertexCount, 0);
+
+    std::vector<GLuint> wedge(vertexCount, UINT32_MAX);
+    for (GLuint vertex : indices) {
+        GLuint position = canonical[vertex];
+        if (wedge[position] == UINT32_MAX) {
+            wedge[position] = vertex;
+        } else if (wedge[position] != vertex) {
+            lockedCanonical[position] = 1;
+        }
+    }
+
+    std::vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        for (size_t corner = 0; corner < 3; ++corner) {
+            uint64_t a = canonical[indices[i + corner]];
+            uint64_t b = canonical[indices[i + (corner + 1) % 3]];
+            edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t i = 0; i < edges.size();) {
+        size_t end = i + 1;
+        while (end < edges.size() && edges[end] == edges[i]) {
+            ++end;
+        }
+        if (end - i != 2) {
+            lockedCanonical[edges[i] >> 32] = 1;
+            lockedCanonical[edges[i] & 0xffffffffu] = 1;
+        }
+        i = end;
+    }
+
+    std::vector<char> locked(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        locked[i] = lockedCanonical[canonical[i]];
+    }
+    return locked;
+}
+
+// Whether moving from onto to would flip a remaining triangle around from, or make one of them
+// use another vertex at the position of to (a different side of a seam)
+bool isCollapseRejected(const Collapse& collapse, const std::vector<GLuint>& indices, const std::vector<glm::dvec3>& positions,
+    const std::vector<GLuint>& canonical, const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& adjacency) {
+
+    for (uint32_t k = offsets[collapse.from]; k < offsets[collapse.from + 1]; ++k) {
+        const GLuint* triangle = &indices[adjacency[k] * 3];
+        if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+            continue;
+        }
+        glm::dvec3 before[3], after[3];
+        for (size_t corner = 0; corner < 3; ++corner) {
+            if (canonical[triangle[corner]] == canonical[collapse.to]) {
+                return true;
+            }
+            before[corner] = positions[triangle[corner]];
+            after[corner] = triangle[corner] == collapse.from ? positions[collapse.to] : before[corner];
+        }
+        glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+        glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+        if (glm::dot(normalBefore, normalAfter) <= 0.0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Renumbers the vertices in the order the triangles first reference them and drops the unused ones.
+// LOD levels only use vertices of the full mesh, they are renumbered along.
+void optimizeVertexFetch(MeshData& mesh) {
+    const GLuint UNUSED = UINT32_MAX;
+    std::vector<GLuint> remap(mesh.vertices.size(), UNUSED);
+    GLuint vertexCount = 0;
+    for (GLuint& index : mesh.indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = vertexCount++;
+        }
+        index = remap[index];
+    }
+    for (GLuint& index : mesh.lodIndices) {
+        index = remap[index];
+    }
+
+    std::vector<glm::vec3> vertices(vertexCount);
+    std::vector<glm::vec3> normals(mesh.normals.empty() ? 0 : vertexCount);
+    std::vector<glm::vec2> texCoords(mesh.texCoords.empty() ? 0 : vertexCount);
+    for (size_t i = 0; i < remap.size(); ++i) {
+        GLuint target = remap[i];
+        if (target == UNUSED) {
+            continue;
+        }
+        vertices[target] = mesh.vertices[i];
+        if (!normals.empty()) {
+            normals[target] = mesh.normals[i];
+        }
+        if (!texCoords.empty()) {
+            texCoords[target] = mesh.texCoords[i];
+        }
+    }
+    mesh.vertices.swap(vertices);
+    mesh.normals.swap(normals);
+    mesh.texCoords.swap(texCoords);
+}
+
+// Bounding sphere and normal cone of the triangles of a meshlet, see Meshlet
+void computeMeshletBounds(Meshlet& meshlet, const std::vector<GLuint>& indices, const std::vector<glm::vec3>& positions) {
+    const size_t end = meshlet.firstIndex + meshlet.indexCount;
+    glm::vec3 minimum = positions[indices[meshlet.firstIndex]];
+    glm::vec3 maximum = minimum;
+    glm::vec3 normalSum(0.0f);
+    for (size_t i = meshlet.firstIndex; i < end; i += 3) {
+        const glm::vec3& a = positions[indices[i]];
+        const glm::vec3& b = positions[indices[i + 1]];
+        const glm::vec3& c = positions[indices[i + 2]];
+        minimum = glm::min(minimum, glm::min(a, glm::min(b, c)));
+        maximum = glm::max(maximum, glm::max(a, glm::max(b, c)));
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            normalSum += normal / length;
+        }
+    }
+    meshlet.center = (minimum + maximum) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (size_t i = meshlet.firstIndex; i < end; ++i) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(positions[indices[i]] - meshlet.center));
+    }
+
+    // The axis is the average normal, the cone opens up to the normal furthest from it
+    float axisLength = glm::length(normalSum);
+    meshlet.coneAxis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+    float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+    for (size_t i = meshlet.firstIndex; i < end; i += 3) {
+        const glm::vec3& a = positions[indices[i]];
+        glm::vec3 normal = glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            minDot = std::min(minDot, glm::dot(normal / length, meshlet.coneAxis));
+        }
+    }
+    meshlet.coneCutoff = minDot > MESHLET_MIN_CONE_DOT ? std::sqrt(1.0f - minDot * minDot) : 1.0f;
+}
+
+}
+
+void MeshOptimizer::optimize(MeshData& mesh) {
+    if (mesh.indices.empty() || mesh.indices.size() % 3 != 0) {
+        return;
+    }
+    // Attributes that do not match the positions are left alone rather than guessed
+    if ((!mesh.normals.empty() && mesh.normals.size() != mesh.vertices.size())
+        || (!mesh.texCoords.empty() && mesh.texCoords.size() != mesh.vertices.size())) {
+        return;
+    }
+    for (GLuint index : mesh.indices) {
+        if (index >= mesh.vertices.size()) {
+            return;
+        }
+    }
+
+    std::vector<size_t> hardBoundaries;
+    mesh.indices = optimizeVertexCache(mesh.indices, mesh.vertices.size(), CACHE_SIZE, hardBoundaries);
+    mesh.indices = optimizeOverdraw(mesh.indices, mesh.vertices, hardBoundaries, CACHE_SIZE);
+    optimizeVertexFetch(mesh);
+}
+
+void MeshOptimizer::buildMeshlets(MeshData& mesh) {
+    mesh.meshlets.clear();
+    mesh.closed = false;
+    if (mesh.indices.empty() || mesh.indices.size() % 3 != 0) {
+        return;
+    }
+    for (GLuint index : mesh.indices) {
+        if (index >= mesh.vertices.size()) {
+            return;
+        }
+    }
+
+    // Neighbours are found through positions, so meshlets grow across attribute seams
+    const size_t triangleCount = mesh.indices.size() / 3;
+    std::vector<GLuint> canonical = findCanonicalVertices(mesh.vertices);
+    std::vector<GLuint> positionIndices(mesh.indices.size());
+    for (size_t i = 0; i < mesh.indices.size(); ++i) {
+        positionIndices[i] = canonical[mesh.indices[i]];
+    }
+    mesh.closed = isClosedSurface(positionIndices);
+    std::vector<uint32_t> offsets, adjacency;
+    buildAdjacency(positionIndices, mesh.vertices.size(), offsets, adjacency);
+
+    std::vector<glm::vec3> centroids(triangleCount);
+    std::vector<glm::vec3> normals(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const glm::vec3& a = mesh.vertices[mesh.indices[t * 3]];
+        const glm::vec3& b = mesh.vertices[mesh.indices[t * 3 + 1]];
+        const glm::vec3& c = mesh.vertices[mesh.indices[t * 3 + 2]];
+        centroids[t] = (a + b + c) / 3.0f;
+        glm::vec3 normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+    }
+
+    // Each meshlet grows over the triangles next to it, preferring the ones that share the most
+    // vertices with it and then the ones closest to its centroid
+    const uint32_t NONE = UINT32_MAX;
+    std::vector<uint32_t> triangleMeshlet(triangleCount, NONE);
+    std::vector<uint32_t> candidateMeshlet(triangleCount, NONE);
+    std::vector<uint32_t> vertexMeshlet(mesh.vertices.size(), NONE);
+    // triangles around each vertex that are not in a meshlet yet
+    std::vector<uint32_t> liveTriangles(mesh.vertices.size());
+    for (size_t i = 0; i < liveTriangles.size(); ++i) {
+        liveTriangles[i] = offsets[i + 1] - offsets[i];
+    }
+    std::vector<uint32_t> triangles, candidates;
+    std::vector<GLuint> indices;
+    indices.reserve(mesh.indices.size());
+    size_t cursor = 0;
+    while (true) {
+        // The next meshlet starts next to the previous one, at the triangle left over with the fewest
+        // free neighbours, so meshlets do not strand small fragments between them. Otherwise it starts
+        // at the first free triangle of the cache-optimized order.
+        uint32_t next = NONE;
+        uint32_t nextLive = UINT32_MAX;
+        for (uint32_t triangle : candidates) {
+            if (triangleMeshlet[triangle] != NONE) {
+                continue;
+            }
+            uint32_t live = 0;
+            for (size_t corner = 0; corner < 3; ++corner) {
+                live += liveTriangles[positionIndices[triangle * 3 + corner]];
+            }
+            if (live < nextLive) {
+                next = triangle;
+                nextLive = live;
+            }
+        }
+        if (next == NONE) {
+            while (cursor < triangleCount && triangleMeshlet[cursor] != NONE) {
+                ++cursor;
+            }
+            if (cursor == triangleCount) {
+                break;
+            }
+            next = static_cast<uint32_t>(cursor);
+        }
+        const uint32_t meshletIndex = static_cast<uint32_t>(mesh.meshlets.size());
+        triangles.clear();
+        candidates.clear();
+        glm::vec3 centroidSum(0.0f), normalSum(0.0f);
+        while (true) {
+            triangleMeshlet[next] = meshletIndex;
+            triangles.push_back(next);
+            centroidSum += centroids[next];
+            normalSum += normals[next];
+            for (size_t corner = 0; corner < 3; ++corner) {
+                GLuint vertex = positionIndices[next * 3 + corner];
+                vertexMeshlet[vertex] = meshletIndex;
+                --liveTriangles[vertex];
+                for (uint32_t k = offsets[vertex]; k < offsets[vertex + 1]; ++k) {
+                    uint32_t neighbour = adjacency[k];
+                    if (triangleMeshlet[neighbour] == NONE && candidateMeshlet[neighbour] != meshletIndex) {
+                        candidateMeshlet[neighbour] = meshletIndex;
+                        candidates.push_back(neighbour);
+                    }
+                }
+            }
+            if (triangles.size() >= MESHLET_TRIANGLES) {
+                break;
+            }
+
+            const glm::vec3 centroid = centroidSum / static_cast<float>(triangles.size());
+            const float normalLength = glm::length(normalSum);
+            const glm::vec3 averageNormal = normalLength > 0.0f ? normalSum / normalLength : glm::vec3(0.0f);
+            const bool limitNormals = triangles.size() >= MESHLET_MIN_TRIANGLES;
+            size_t best = SIZE_MAX;
+            int bestShared = 0;
+            float bestDistance = 0.0f;
+            for (size_t c = 0; c < candidates.size(); ) {
+                uint32_t triangle = candidates[c];
+                if (triangleMeshlet[triangle] != NONE) {
+                    candidates[c] = candidates.back();
+                    candidates.pop_back();
+                    continue;
+                }
+                if (!limitNormals || glm::dot(normals[triangle], averageNormal) >= MESHLET_NORMAL_LIMIT) {
+                    int shared = 0;
+                    for (size_t corner = 0; corner < 3; ++corner) {
+                        shared += vertexMeshlet[positionIndices[triangle * 3 + corner]] == meshletIndex ? 1 : 0;
+                    }
+                    glm::vec3 offset = centroids[triangle] - centroid;
+                    float distance = glm::dot(offset, offset);
+                    if (best == SIZE_MAX || shared > bestShared || (shared == bestShared && distance < bestDistance)) {
+                        best = c;
+                        bestShared = shared;
+                        bestDistance = distance;
+                    }
+                }
+                ++c;
+            }
+            if (best == SIZE_MAX) {
+                break;
+            }
+            next = candidates[best];
+        }
+
+        // Triangles keep their cache-optimized order within the meshlet
+        std::sort(triangles.begin(), triangles.end());
+        Meshlet meshlet = {};
+        meshlet.firstIndex = static_cast<GLuint>(indices.size());
+        meshlet.indexCount = static_cast<GLuint>(triangles.size() * 3);
+        for (uint32_t triangle : triangles) {
+            indices.insert(indices.end(), mesh.indices.begin() + triangle * 3, mesh.indices.begin() + triangle * 3 + 3);
+        }
+        mesh.meshlets.push_back(meshlet);
+    }
+
+    mesh.indices.swap(indices);
+    for (Meshlet& meshlet : mesh.meshlets) {
+        computeMeshletBounds(meshlet, mesh.indices, mesh.vertices);
+    }
+    optimizeVertexFetch(mesh);
+}
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, unsigned int cacheSize) {
+    VertexCacheStats stats;
+    stats.triangles = indices.size() / 3;
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<char> referenced(vertexCount, 0);
+    for (size_t i = 0; i < stats.triangles * 3; ++i) {
+        GLuint vertex = indices[i];
+        if (vertex >= vertexCount) {
+            continue;
+        }
+        if (!referenced[vertex]) {
+            referenced[vertex] = 1;
+            ++stats.vertices;
+        }
+        if (cache.access(vertex)) {
+            ++stats.misses;
+        }
+    }
+    return stats;
+}
+
+void MeshOptimizer::generateLods(MeshData& mesh) {
+    mesh.lodIndices.clear();
+    mesh.lodIndexCounts.clear();
+    if (mesh.indices.size() % 3 != 0 || mesh.indices.size() / 3 < 2 * MIN_LOD_TRIANGLES) {
+        return;
+    }
+    for (GLuint index : mesh.indices) {
+        if (index >= mesh.vertices.size()) {
+            return;
+        }
+    }
+
+    // Each level is simplified from the full mesh, so errors do not pile up along the chain
+    size_t previousCount = mesh.indices.size();
+    for (size_t level = 1; level <= MAX_LOD_COUNT; ++level) {
+        size_t targetCount = static_cast<size_t>(previousCount * LOD_TRIANGLE_RATIO) / 3 * 3;
+        if (targetCount / 3 < MIN_LOD_TRIANGLES) {
+            break;
+        }
+        float targetError = LOD_BASE_ERROR * static_cast<float>(1 << (level - 1));
+        std::vector<GLuint> lod = simplify(mesh.indices, mesh.vertices, targetCount, targetError);
+        if (lod.empty() || lod.size() > previousCount * LOD_MIN_REDUCTION) {
+            break;
+        }
+        std::vector<size_t> hardBoundaries;
+        lod = optimizeVertexCache(lod, mesh.vertices.size(), CACHE_SIZE, hardBoundaries);
+        mesh.lodIndices.insert(mesh.lodIndices.end(), lod.begin(), lod.end());
+        mesh.lodIndexCounts.push_back(static_cast<GLuint>(lod.size()));
+        previousCount = lod.size();
+    }
+}
+
+std::vector<GLuint> MeshOptimizer::simplify(const std::vector<GLuint>& indices, const std::vector<glm::vec3>& vertices,
+    size_t targetIndexCount, float targetError, float* resultError) {
+
+    if (resultError) {
+        *resultError = 0.0f;
+    }
+    std::vector<GLuint> result;
+    result.reserve(indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        GLuint a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a != b && b != c && a != c) {
+            result.push_back(a);
+            result.push_back(b);
+            result.push_back(c);
+        }
+    }
+    if (result.size() <= targetIndexCount) {
+        return result;
+    }
+
+    // Positions are normalized to the mesh size, which makes the errors relative to it
+    glm::vec3 minimum = vertices[result[0]], maximum = minimum;
+    for (GLuint vertex : result) {
+        minimum = glm::min(minimum, vertices[vertex]);
+        maximum = glm::max(maximum, vertices[vertex]);
+    }
+    glm::vec3 extent = maximum - minimum;
+    double size = std::max(extent.x, std::max(extent.y, extent.z));
+    double scale = size > 0.0 ? 1.0 / size : 1.0;
+    std::vector<glm::dvec3> positions(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        positions[i] = glm::dvec3(vertices[i] - minimum) * scale;
+    }
+
+    std::vector<GLuint> canonical = findCanonicalVertices(vertices);
+    std::vector<char> locked = findLockedVertices(result, canonical);
+    std::vector<Quadric> quadrics(vertices.size());
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const glm::dvec3& a = positions[result[i]];
+        glm::dvec3 cross = glm::cross(positions[result[i + 1]] - a, positions[result[i + 2]] - a);
+        double length = glm::length(cross);
+        if (length == 0.0) {
+            continue;
+        }
+        glm::dvec3 normal = cross / length;
+        for (size_t corner = 0; corner < 3; ++corner) {
+            quadrics[result[i + corner]].addPlane(normal, -glm::dot(normal, a), length * 0.5);
+        }
+    }
+
+    // Passes of independent collapses, cheapest first: a collapse fixes the one-ring of the moved
+    // vertex for the rest of the pass, so the flip tests of later collapses stay valid
+    const double maxError = static_cast<double>(targetError) * targetError;
+    double reachedError = 0.0;
+    std::vector<uint32_t> offsets, adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<GLuint> remap(vertices.size());
+    std::vector<char> touched(vertices.size());
+    while (result.size() > targetIndexCount) {
+        buildAdjacency(result, vertices.size(), offsets, adjacency);
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (size_t corner = 0; corner < 3; ++corner) {
+                GLuint a = result[i + corner];
+                GLuint b = result[i + (corner + 1) % 3];
+                if (!locked[a]) {
+                    collapses.push_back({ a, b, quadrics[a].getError(positions[b]) });
+                }
+                if (!locked[b]) {
+                    collapses.push_back({ b, a, quadrics[b].getError(positions[a]) });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.error < b.error;
+        });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), 0);
+        // An interior collapse removes two triangles
+        const size_t removableTriangles = (result.size() - targetIndexCount) / 3;
+        size_t removedTriangles = 0;
+        for (const Collapse& collapse : collapses) {
+            if (collapse.error > maxError || removedTriangles >= removableTriangles) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]
+                || isCollapseRejected(collapse, result, positions, canonical, offsets, adjacency)) {
+                continue;
+            }
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            reachedError = std::max(reachedError, collapse.error);
+            for (uint32_t k = offsets[collapse.from]; k < offsets[collapse.from + 1]; ++k) {
+                for (size_t corner = 0; corner < 3; ++corner) {
+                    touched[result[adjacency[k] * 3 + corner]] = 1;
+                }
+            }
+            removedTriangles += 2;
+        }
+        if (removedTriangles == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            GLuint a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a != b && b != c && a != c) {
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+        }
+        result.resize(write);
+    }
+
+    if (resultError) {
+        *resultError = static_cast<float>(std::sqrt(reachedError));
+    }
+    return result;
+}
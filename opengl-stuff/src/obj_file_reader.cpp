@@ -0,0 +1,725 @@
+#include "obj_file_reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "mapped_file.h"
+#include "thread_pool.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const int32_t NO_INDEX = INT32_MIN;
+// Chunks are small enough to balance the threads but large enough to keep the per-chunk cost low
+const size_t MIN_CHUNK_SIZE = 64 * 1024;
+// Mesh and material names Assimp uses when the file does not set one
+const char* const DEFAULT_OBJECT_NAME = "defaultobject";
+
+// One corner of a triangle, as 0-based indices into the whole file's attribute arrays
+struct Corner {
+    int32_t position;
+    int32_t texCoord;
+    int32_t normal;
+};
+
+// An o/g/usemtl line, applied to the corners that follow it
+struct Directive {
+    enum Kind { Object, Material };
+    Kind kind;
+    size_t corner;
+    std::string name;
+};
+
+// A relative (negative) index that could only be resolved against the chunk's own counts.
+// The chunk's offset into the whole file is added once every chunk has been parsed.
+struct Fixup {
+    size_t corner;
+    int field;
+};
+
+struct Chunk {
+    const char* begin;
+    const char* end;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::vector<glm::vec3> normals;
+    std::vector<Corner> corners;
+    std::vector<Fixup> fixups;
+    std::vector<Directive> directives;
+    std::vector<std::string> libraries;
+    bool valid = true;
+};
+
+// A run of corners with the same object and material, which becomes one mesh
+struct CornerRange {
+    size_t chunk;
+    size_t begin;
+    size_t end;
+};
+
+struct Segment {
+    std::string object;
+    std::string material;
+    std::vector<CornerRange> ranges;
+    size_t cornerCount = 0;
+};
+
+const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+// Parses a decimal float. Numbers with up to 19 significant digits and a small exponent, which is
+// every number an exporter writes, are computed exactly in double and rounded once to float.
+// Anything else goes through strtod.
+const char* parseFloat(const char* p, const char* end, float& out) {
+    p = skipBlanks(p, end);
+    const char* start = p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool seenDigit = false;
+    for (; p < end && isDigit(*p); ++p) {
+        seenDigit = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0) {
+                ++digits;
+            }
+        } else {
+            ++exponent;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && isDigit(*p); ++p) {
+            seenDigit = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0) {
+                    ++digits;
+                }
+                --exponent;
+            }
+        }
+    }
+    if (!seenDigit) {
+        out = 0.0f;
+        return start;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* exponentStart = p++;
+        bool exponentNegative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            exponentNegative = *p == '-';
+            ++p;
+        }
+        if (p < end && isDigit(*p)) {
+            int value = 0;
+            for (; p < end && isDigit(*p); ++p) {
+                value = std::min(value * 10 + (*p - '0'), 100000);
+            }
+            exponent += exponentNegative ? -value : value;
+        } else {
+            p = exponentStart;
+        }
+    }
+
+    if (mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        double value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / POWERS_OF_TEN[-exponent] : value * POWERS_OF_TEN[exponent];
+        out = static_cast<float>(negative ? -value : value);
+    } else {
+        std::string text(start, p);
+        out = static_cast<float>(std::strtod(text.c_str(), nullptr));
+    }
+    return p;
+}
+
+inline const char* parseInt(const char* p, const char* end, int32_t& out, bool& ok) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    ok = p < end && isDigit(*p);
+    int64_t value = 0;
+    for (; p < end && isDigit(*p); ++p) {
+        value = std::min<int64_t>(value * 10 + (*p - '0'), INT32_MAX);
+    }
+    out = static_cast<int32_t>(negative ? -value : value);
+    return p;
+}
+
+// Rest of the line without surrounding blanks, used for names and paths that may contain spaces
+std::string readRest(const char* p, const char* end) {
+    p = skipBlanks(p, end);
+    while (end > p && isBlank(end[-1])) {
+        --end;
+    }
+    return std::string(p, end);
+}
+
+// Whether the line starts with the keyword followed by a blank
+inline bool startsWithKeyword(const char* p, const char* end, const char* keyword, size_t length) {
+    return static_cast<size_t>(end - p) > length && std::memcmp(p, keyword, length) == 0 && isBlank(p[length]);
+}
+
+// Turns a 1-based OBJ index into a 0-based one. Negative indices count back from the last
+// attribute read, they are resolved against the chunk's own count and flagged for a fixup.
+inline void resolveIndex(int32_t raw, size_t localCount, int32_t& out, bool& relative) {
+    relative = raw < 0;
+    out = relative ? static_cast<int32_t>(localCount) + raw : raw - 1;
+}
+
+void parseFace(const char* p, const char* end, Chunk& chunk, std::vector<Corner>& face, std::vector<unsigned char>& relative) {
+    face.clear();
+    relative.clear();
+    while (true) {
+        p = skipBlanks(p, end);
+        if (p >= end) {
+            break;
+        }
+        Corner corner = { NO_INDEX, NO_INDEX, NO_INDEX };
+        unsigned char relativeFields = 0;
+        bool isRelative;
+        int32_t raw;
+        bool ok;
+        p = parseInt(p, end, raw, ok);
+        if (!ok || raw == 0) {
+            chunk.valid = false;
+            return;
+        }
+        resolveIndex(raw, chunk.positions.size(), corner.position, isRelative);
+        relativeFields |= isRelative ? 1 : 0;
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/') {
+                p = parseInt(p, end, raw, ok);
+                if (ok && raw != 0) {
+                    resolveIndex(raw, chunk.texCoords.size(), corner.texCoord, isRelative);
+                    relativeFields |= isRelative ? 2 : 0;
+                }
+            }
+            if (p < end && *p == '/') {
+                ++p;
+                p = parseInt(p, end, raw, ok);
+                if (ok && raw != 0) {
+                    resolveIndex(raw, chunk.normals.size(), corner.normal, isRelative);
+                    relativeFields |= isRelative ? 4 : 0;
+                }
+            }
+        }
+        face.push_back(corner);
+        relative.push_back(relativeFields);
+        // Skip anything unexpected up to the next corner
+        while (p < end && !isBlank(*p)) {
+            ++p;
+        }
+    }
+
+    // Fan triangulation, like Assimp's Triangulate step for the convex polygons exporters write
+    for (size_t i = 1; i + 1 < face.size(); ++i) {
+        const size_t triangle[3] = { 0, i, i + 1 };
+        for (size_t corner : triangle) {
+            for (int field = 0; field < 3; ++field) {
+                if (relative[corner] & (1 << field)) {
+                    chunk.fixups.push_back({ chunk.corners.size(), field });
+                }
+            }
+            chunk.corners.push_back(face[corner]);
+        }
+    }
+}
+
+void parseChunk(Chunk& chunk) {
+    std::vector<Corner> face;
+    std::vector<unsigned char> relative;
+    const char* p = chunk.begin;
+    while (p < chunk.end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+        if (!lineEnd) {
+            lineEnd = chunk.end;
+        }
+        const char* line = skipBlanks(p, lineEnd);
+        p = lineEnd + 1;
+        if (line >= lineEnd) {
+            continue;
+        }
+
+        switch (line[0]) {
+        case 'v':
+            if (lineEnd - line > 1 && isBlank(line[1])) {
+                glm::vec3 position;
+                const char* q = parseFloat(line + 1, lineEnd, position.x);
+                q = parseFloat(q, lineEnd, position.y);
+                parseFloat(q, lineEnd, position.z);
+                chunk.positions.push_back(position);
+            } else if (startsWithKeyword(line, lineEnd, "vt", 2)) {
+                glm::vec2 texCoord;
+                const char* q = parseFloat(line + 2, lineEnd, texCoord.x);
+                parseFloat(q, lineEnd, texCoord.y);
+                // FlipUVs, OpenGL samples textures bottom-up
+                texCoord.y = 1.0f - texCoord.y;
+                chunk.texCoords.push_back(texCoord);
+            } else if (startsWithKeyword(line, lineEnd, "vn", 2)) {
+                glm::vec3 normal;
+                const char* q = parseFloat(line + 2, lineEnd, normal.x);
+                q = parseFloat(q, lineEnd, normal.y);
+                parseFloat(q, lineEnd, normal.z);
+                chunk.normals.push_back(normal);
+            }
+            break;
+        case 'f':
+            if (lineEnd - line > 1 && isBlank(line[1])) {
+                parseFace(line + 1, lineEnd, chunk, face, relative);
+            }
+            break;
+        case 'o':
+        case 'g':
+            if (lineEnd - line > 1 && isBlank(line[1])) {
+                std::string name = readRest(line + 1, lineEnd);
+                if (!name.empty()) {
+                    chunk.directives.push_back({ Directive::Object, chunk.corners.size(), name });
+                }
+            }
+            break;
+        case 'u':
+            if (startsWithKeyword(line, lineEnd, "usemtl", 6)) {
+                chunk.directives.push_back({ Directive::Material, chunk.corners.size(), readRest(line + 6, lineEnd) });
+            }
+            break;
+        case 'm':
+            if (startsWithKeyword(line, lineEnd, "mtllib", 6)) {
+                chunk.libraries.push_back(readRest(line + 6, lineEnd));
+            }
+            break;
+        default:
+            // comments, smoothing groups, lines and points are not used by the viewer
+            break;
+        }
+    }
+}
+
+// Cuts the file into line-aligned chunks of roughly equal size
+std::vector<Chunk> splitChunks(const char* data, size_t size, unsigned int threads) {
+    size_t targetSize = std::max(MIN_CHUNK_SIZE, size / (static_cast<size_t>(threads) * 4) + 1);
+    std::vector<Chunk> chunks;
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end) {
+        const char* chunkEnd = p + std::min(targetSize, static_cast<size_t>(end - p));
+        if (chunkEnd < end) {
+            const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+            chunkEnd = newline ? newline + 1 : end;
+        }
+        Chunk chunk;
+        chunk.begin = p;
+        chunk.end = chunkEnd;
+        chunks.push_back(std::move(chunk));
+        p = chunkEnd;
+    }
+    return chunks;
+}
+
+// Open addressing map from a corner's index triple to its welded vertex
+class CornerMap {
+public:
+    explicit CornerMap(size_t capacity) {
+        size_t size = 16;
+        while (size < capacity * 2) {
+            size <<= 1;
+        }
+        slots.assign(size, Slot{ { NO_INDEX, NO_INDEX, NO_INDEX }, 0 });
+        mask = size - 1;
+    }
+
+    // Returns the vertex of the corner, or adds it as vertex next and returns next
+    GLuint insert(const Corner& corner, GLuint next) {
+        uint64_t hash = (static_cast<uint64_t>(static_cast<uint32_t>(corner.position)) * 0x9E3779B97F4A7C15ULL)
+            ^ (static_cast<uint64_t>(static_cast<uint32_t>(corner.texCoord)) * 0xC2B2AE3D27D4EB4FULL)
+            ^ (static_cast<uint64_t>(static_cast<uint32_t>(corner.normal)) * 0x165667B19E3779F9ULL);
+        size_t i = static_cast<size_t>(hash ^ (hash >> 29)) & mask;
+        while (true) {
+            Slot& slot = slots[i];
+            if (slot.corner.position == NO_INDEX) {
+                slot.corner = corner;
+                slot.vertex = next;
+                return next;
+            }
+            if (slot.corner.position == corner.position && slot.corner.texCoord == corner.texCoord && slot.corner.normal == corner.normal) {
+                return slot.vertex;
+            }
+            i = (i + 1) & mask;
+        }
+    }
+
+private:
+    struct Slot {
+        Corner corner;
+        GLuint vertex;
+    };
+    std::vector<Slot> slots;
+    size_t mask;
+};
+
+MeshData buildMesh(const Segment& segment, const std::vector<Chunk>& chunks,
+    const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& texCoords, const std::vector<glm::vec3>& normals,
+    unsigned int materialIndex) {
+
+    MeshData mesh;
+    mesh.name = segment.object;
+    mesh.materialIndex = materialIndex;
+
+    bool hasTexCoords = false;
+    for (const CornerRange& range : segment.ranges) {
+        const Corner* corners = chunks[range.chunk].corners.data();
+        for (size_t i = range.begin; i < range.end && !hasTexCoords; ++i) {
+            hasTexCoords = corners[i].texCoord != NO_INDEX;
+        }
+    }
+
+    CornerMap cornerMap(segment.cornerCount);
+    mesh.indices.resize(segment.cornerCount);
+    mesh.vertices.reserve(segment.cornerCount);
+    mesh.normals.reserve(segment.cornerCount);
+    if (hasTexCoords) {
+        mesh.texCoords.reserve(segment.cornerCount);
+    }
+    size_t index = 0;
+    for (const CornerRange& range : segment.ranges) {
+        const Corner* corners = chunks[range.chunk].corners.data();
+        for (size_t i = range.begin; i < range.end; ++i) {
+            const Corner& corner = corners[i];
+            GLuint next = static_cast<GLuint>(mesh.vertices.size());
+            GLuint vertex = cornerMap.insert(corner, next);
+            if (vertex == next) {
+                mesh.vertices.push_back(positions[corner.position]);
+                mesh.normals.push_back(corner.normal != NO_INDEX ? normals[corner.normal] : glm::vec3(0.0f, 1.0f, 0.0f));
+                if (hasTexCoords) {
+                    mesh.texCoords.push_back(corner.texCoord != NO_INDEX ? texCoords[corner.texCoord] : glm::vec2(0.0f, 1.0f));
+                }
+            }
+            mesh.indices[index++] = vertex;
+        }
+    }
+    mesh.vertices.shrink_to_fit();
+    mesh.normals.shrink_to_fit();
+    mesh.texCoords.shrink_to_fit();
+    return mesh;
+}
+
+bool readColor(const char* p, const char* end, glm::vec3& color) {
+    const char* q = parseFloat(p, end, color.r);
+    if (q == skipBlanks(p, end)) {
+        return false;
+    }
+    // "Kd 0.5" sets all three channels
+    const char* g = parseFloat(q, end, color.g);
+    if (g == skipBlanks(q, end)) {
+        color.g = color.b = color.r;
+        return true;
+    }
+    parseFloat(g, end, color.b);
+    return true;
+}
+
+// Texture path of a map_* statement, without the options that may precede it
+std::string readTexturePath(const char* p, const char* end) {
+    p = skipBlanks(p, end);
+    while (p < end && *p == '-') {
+        const char* optionEnd = p;
+        while (optionEnd < end && !isBlank(*optionEnd)) {
+            ++optionEnd;
+        }
+        std::string option(p, optionEnd);
+        p = skipBlanks(optionEnd, end);
+        // -o, -s and -t take up to three numbers, -mm two, the other options one argument
+        int maxArguments = (option == "-o" || option == "-s" || option == "-t") ? 3 : option == "-mm" ? 2 : 1;
+        for (int i = 0; i < maxArguments && p < end; ++i) {
+            bool numeric = isDigit(*p) || *p == '-' || *p == '+' || *p == '.';
+            if (i > 0 && !numeric) {
+                break;
+            }
+            while (p < end && !isBlank(*p)) {
+                ++p;
+            }
+            p = skipBlanks(p, end);
+        }
+    }
+    return readRest(p, end);
+}
+
+// Material as Assimp's OBJ importer fills it, converted the way ObjectReader::readMaterial does
+struct MtlMaterial {
+    glm::vec3 ambient = glm::vec3(0.0f);
+    glm::vec3 diffuse = glm::vec3(0.6f);
+    glm::vec3 specular = glm::vec3(0.0f);
+    glm::vec3 emissive = glm::vec3(0.0f);
+    float shininess = 0.0f;
+    float opacity = 1.0f;
+    std::string diffuseTexture;
+    std::string ambientTexture;
+
+    Material toMaterial() const {
+        Material material;
+        if (ambient != glm::vec3(0.0f)) {
+            material.ambientColor = ambient;
+        }
+        material.diffuseColor = diffuse;
+        material.specularColor = specular;
+        material.emissiveColor = emissive;
+        material.shininess = shininess == 0.0f ? 1.0f : shininess;
+        material.opacity = opacity;
+        // readMaterial visits the ambient texture after the diffuse one, so it wins
+        material.texturePath = !ambientTexture.empty() ? ambientTexture : diffuseTexture;
+        return material;
+    }
+};
+
+void readMaterialLibrary(const std::string& path, std::vector<std::string>& names, std::vector<MtlMaterial>& materials) {
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        std::cerr << "ObjFileReader: material library not found: " << path << std::endl;
+        return;
+    }
+    const char* p = reinterpret_cast<const char*>(file.data());
+    const char* end = p + file.size();
+    MtlMaterial* current = nullptr;
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        const char* line = skipBlanks(p, lineEnd);
+        p = lineEnd + 1;
+        if (line >= lineEnd || *line == '#') {
+            continue;
+        }
+        if (startsWithKeyword(line, lineEnd, "newmtl", 6)) {
+            names.push_back(readRest(line + 6, lineEnd));
+            materials.push_back(MtlMaterial());
+            current = &materials.back();
+            continue;
+        }
+        if (!current) {
+            continue;
+        }
+        if (startsWithKeyword(line, lineEnd, "Ka", 2)) {
+            readColor(line + 2, lineEnd, current->ambient);
+        } else if (startsWithKeyword(line, lineEnd, "Kd", 2)) {
+            readColor(line + 2, lineEnd, current->diffuse);
+        } else if (startsWithKeyword(line, lineEnd, "Ks", 2)) {
+            readColor(line + 2, lineEnd, current->specular);
+        } else if (startsWithKeyword(line, lineEnd, "Ke", 2)) {
+            readColor(line + 2, lineEnd, current->emissive);
+        } else if (startsWithKeyword(line, lineEnd, "Ns", 2)) {
+            parseFloat(line + 2, lineEnd, current->shininess);
+        } else if (startsWithKeyword(line, lineEnd, "d", 1)) {
+            parseFloat(line + 1, lineEnd, current->opacity);
+        } else if (startsWithKeyword(line, lineEnd, "Tr", 2)) {
+            float transparency;
+            parseFloat(line + 2, lineEnd, transparency);
+            current->opacity = 1.0f - transparency;
+        } else if (startsWithKeyword(line, lineEnd, "map_Kd", 6)) {
+            current->diffuseTexture = readTexturePath(line + 6, lineEnd);
+        } else if (startsWithKeyword(line, lineEnd, "map_Ka", 6)) {
+            current->ambientTexture = readTexturePath(line + 6, lineEnd);
+        }
+    }
+}
+
+bool hasObjExtension(const std::string& filePath) {
+    std::string extension = fs::path(filePath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".obj";
+}
+
+}
+
+bool ObjFileReader::canRead(const std::string& filePath) {
+    return hasObjExtension(filePath);
+}
+
+bool ObjFileReader::read(const std::string& filePath, ModelData& model, ImportListener* listener) {
+    MappedFile file(filePath);
+    if (!file.isOpen()) {
+        std::cerr << "ObjFileReader: failed to open " << filePath << std::endl;
+        return false;
+    }
+    ThreadPool& pool = ThreadPool::shared();
+    const char* data = reinterpret_cast<const char*>(file.data());
+
+    // Parse the chunks in parallel (first half of the progress)
+    std::vector<Chunk> chunks = splitChunks(data, file.size(), pool.getConcurrency());
+    std::atomic<size_t> parsed(0);
+    pool.parallelFor(chunks.size(), [&](size_t i) {
+        if (listener && listener->isCancelled()) {
+            return;
+        }
+        parseChunk(chunks[i]);
+        if (listener) {
+            listener->onProgress(0.5f * static_cast<float>(++parsed) / chunks.size());
+        }
+    });
+    if (listener && listener->isCancelled()) {
+        return false;
+    }
+
+    // Chunk offsets into the whole file's attribute arrays
+    std::vector<size_t> positionBase(chunks.size()), texCoordBase(chunks.size()), normalBase(chunks.size());
+    size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (!chunks[i].valid) {
+            std::cerr << "ObjFileReader: malformed face in " << filePath << std::endl;
+            return false;
+        }
+        positionBase[i] = positionCount;
+        texCoordBase[i] = texCoordCount;
+        normalBase[i] = normalCount;
+        positionCount += chunks[i].positions.size();
+        texCoordCount += chunks[i].texCoords.size();
+        normalCount += chunks[i].normals.size();
+    }
+
+    std::vector<glm::vec3> positions(positionCount);
+    std::vector<glm::vec2> texCoords(texCoordCount);
+    std::vector<glm::vec3> normals(normalCount);
+    std::atomic<bool> indicesValid(true);
+    pool.parallelFor(chunks.size(), [&](size_t i) {
+        Chunk& chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + positionBase[i]);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + texCoordBase[i]);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + normalBase[i]);
+        std::vector<glm::vec3>().swap(chunk.positions);
+        std::vector<glm::vec2>().swap(chunk.texCoords);
+        std::vector<glm::vec3>().swap(chunk.normals);
+
+        for (const Fixup& fixup : chunk.fixups) {
+            Corner& corner = chunk.corners[fixup.corner];
+            int32_t& index = fixup.field == 0 ? corner.position : fixup.field == 1 ? corner.texCoord : corner.normal;
+            size_t base = fixup.field == 0 ? positionBase[i] : fixup.field == 1 ? texCoordBase[i] : normalBase[i];
+            index += static_cast<int32_t>(base);
+        }
+        for (const Corner& corner : chunk.corners) {
+            if (corner.position < 0 || static_cast<size_t>(corner.position) >= positionCount
+                || (corner.texCoord != NO_INDEX && (corner.texCoord < 0 || static_cast<size_t>(corner.texCoord) >= texCoordCount))
+                || (corner.normal != NO_INDEX && (corner.normal < 0 || static_cast<size_t>(corner.normal) >= normalCount))) {
+                indicesValid = false;
+                return;
+            }
+        }
+    });
+    if (!indicesValid) {
+        std::cerr << "ObjFileReader: index out of range in " << filePath << std::endl;
+        return false;
+    }
+
+    // Materials, index 0 is the default material Assimp adds to every OBJ
+    std::vector<std::string> materialNames = { "DefaultMaterial" };
+    std::vector<MtlMaterial> materials(1);
+    std::vector<std::string> libraries;
+    for (const Chunk& chunk : chunks) {
+        for (const std::string& library : chunk.libraries) {
+            if (std::find(libraries.begin(), libraries.end(), library) == libraries.end()) {
+                libraries.push_back(library);
+                readMaterialLibrary((fs::path(filePath).parent_path() / library).string(), materialNames, materials);
+            }
+        }
+    }
+    std::map<std::string, unsigned int> materialIndices;
+    for (size_t i = materialNames.size(); i-- > 0;) {
+        // the first definition of a name wins
+        materialIndices[materialNames[i]] = static_cast<unsigned int>(i);
+    }
+
+    // Walk the directives in file order to cut the corners into meshes
+    std::vector<Segment> segments(1);
+    segments.back().object = DEFAULT_OBJECT_NAME;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        const Chunk& chunk = chunks[i];
+        size_t position = 0;
+        auto addRange = [&](size_t end) {
+            if (end > position) {
+                segments.back().ranges.push_back({ i, position, end });
+                segments.back().cornerCount += end - position;
+            }
+            position = end;
+        };
+        for (const Directive& directive : chunk.directives) {
+            addRange(directive.corner);
+            const Segment& current = segments.back();
+            bool changes = directive.kind == Directive::Object ? directive.name != current.object : directive.name != current.material;
+            if (!changes) {
+                continue;
+            }
+            if (current.cornerCount > 0) {
+                Segment next;
+                next.object = current.object;
+                next.material = current.material;
+                segments.push_back(next);
+            }
+            if (directive.kind == Directive::Object) {
+                segments.back().object = directive.name;
+            } else {
+                segments.back().material = directive.name;
+            }
+        }
+        addRange(chunk.corners.size());
+    }
+    segments.erase(std::remove_if(segments.begin(), segments.end(), [](const Segment& segment) { return segment.cornerCount == 0; }), segments.end());
+    if (segments.empty()) {
+        std::cerr << "ObjFileReader: no faces in " << filePath << std::endl;
+        return false;
+    }
+
+    // Build the meshes in parallel (second half of the progress)
+    model.materials.clear();
+    for (const MtlMaterial& material : materials) {
+        model.materials.push_back(material.toMaterial());
+    }
+    model.meshes.resize(segments.size());
+    std::atomic<size_t> built(0);
+    pool.parallelFor(segments.size(), [&](size_t i) {
+        if (listener && listener->isCancelled()) {
+            return;
+        }
+        auto material = materialIndices.find(segments[i].material);
+        unsigned int materialIndex = material != materialIndices.end() ? material->second : 0;
+        model.meshes[i] = buildMesh(segments[i], chunks, positions, texCoords, normals, materialIndex);
+        if (listener) {
+            listener->onProgress(0.5f + 0.5f * static_cast<float>(++built) / segments.size());
+        }
+    });
+    return !(listener && listener->isCancelled());
+}
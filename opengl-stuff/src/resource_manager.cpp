@@ -6,24 +6,26 @@
 
 #include <stb/stb_image.h>
 
+#include "gl_state.h"
+
 // Instantiate static variables
 std::map<std::string, FrameBuffer>  ResourceManager::frameBuffers;
 std::map<std::string, Texture2D>    ResourceManager::textures;
 std::map<std::string, Shader>       ResourceManager::shaders;
+std::mutex                          ResourceManager::texturesMutex;
 
-FrameBuffer ResourceManager::loadFrameBuffer(unsigned int width, unsigned int height, std::string name) {
+FrameBuffer& ResourceManager::loadFrameBuffer(unsigned int width, unsigned int height, std::string name) {
     auto frameBufferIt = frameBuffers.find(name);
     // If isn't present
     if (frameBufferIt == frameBuffers.end()) {
-        FrameBuffer frameBuffer;
-        frameBuffer.generate(width, height);
-        frameBuffers[name] = frameBuffer;
-        return frameBuffers[name];
+        FrameBuffer& frameBuffer = frameBuffers[name];
+        frameBuffer.generate(width, height, name);
+        return frameBuffer;
     }
     return frameBufferIt->second;
 }
 
-FrameBuffer ResourceManager::getFrameBuffer(std::string name) {
+FrameBuffer& ResourceManager::getFrameBuffer(std::string name) {
     return frameBuffers[name];
 }
 
@@ -43,45 +45,87 @@ Shader ResourceManager::getShader(std::string name)
     return shaders[name];
 }
 
-Texture2D ResourceManager::loadTexture(const char* file, std::string name)
+Texture2D& ResourceManager::loadTexture(const char* file, std::string name)
+{
+    std::lock_guard<std::mutex> lock(texturesMutex);
+    auto textureIt = textures.find(name);
+    // If isn't present
+    if (textureIt == textures.end()) {
+        Texture2D& texture = textures[name] = loadTextureFromFile(file);
+        GpuMemory::describe(texture.memoryId, GpuMemoryCategory_Textures, name);
+        return texture;
+    }
+    return textureIt->second;
+}
+
+Texture2D& ResourceManager::loadTexture(const ImageData& image, std::string name)
 {
+    std::lock_guard<std::mutex> lock(texturesMutex);
     auto textureIt = textures.find(name);
     // If isn't present
     if (textureIt == textures.end()) {
-        textures[name] = loadTextureFromFile(file);
-        return textures[name];
+        Texture2D& texture = textures[name] = loadTextureFromImage(image, name.c_str());
+        GpuMemory::describe(texture.memoryId, GpuMemoryCategory_Textures, name);
+        return texture;
     }
     return textureIt->second;
 }
 
-Texture2D ResourceManager::loadTexture(const glm::vec4 color, std::string name) {
+Texture2D& ResourceManager::loadTexture(const glm::vec4 color, std::string name) {
+    std::lock_guard<std::mutex> lock(texturesMutex);
     auto textureIt = textures.find(name);
     // If isn't present
     if (textureIt == textures.end()) {
-        textures[name] = loadTextureFromColor(color);
-        return textures[name];
+        Texture2D& texture = textures[name] = loadTextureFromColor(color);
+        GpuMemory::describe(texture.memoryId, GpuMemoryCategory_Textures, name);
+        return texture;
     }
     return textureIt->second;
 }
 
-Texture2D ResourceManager::getTexture(std::string name)
+Texture2D& ResourceManager::getTexture(std::string name)
 {
+    std::lock_guard<std::mutex> lock(texturesMutex);
     return textures[name];
 }
 
-void ResourceManager::clear() {
-    // (properly) delete all frame buffers
-    for (auto iter : frameBuffers) {
-        if (iter.second.id != 0)
-            glDeleteTextures(1, &iter.second.texture.id);
-        glDeleteFramebuffers(1, &iter.second.id);
+bool ResourceManager::hasTexture(std::string name)
+{
+    std::lock_guard<std::mutex> lock(texturesMutex);
+    return textures.find(name) != textures.end();
+}
+
+ImageData ResourceManager::decodeImage(const char* file)
+{
+    ImageData image;
+    unsigned char* data = stbi_load(file, &image.width, &image.height, &image.channels, STBI_default);
+    if (data != nullptr) {
+        image.pixels = std::shared_ptr<unsigned char>(data, stbi_image_free);
+    }
+    return image;
+}
+
+ImageData ResourceManager::decodeImage(const unsigned char* data, size_t size)
+{
+    ImageData image;
+    unsigned char* pixels = stbi_load_from_memory(data, static_cast<int>(size), &image.width, &image.height, &image.channels, STBI_default);
+    if (pixels != nullptr) {
+        image.pixels = std::shared_ptr<unsigned char>(pixels, stbi_image_free);
     }
+    return image;
+}
+
+void ResourceManager::clear() {
+    // frame buffers and textures delete their GL objects themselves
+    frameBuffers.clear();
     // (properly) delete all shaders	
-    for (auto iter : shaders)
+    for (auto iter : shaders) {
+        GLState::forgetProgram(iter.second.ID);
         glDeleteProgram(iter.second.ID);
-    // (properly) delete all textures
-    for (auto iter : textures)
-        glDeleteTextures(1, &iter.second.id);
+    }
+    shaders.clear();
+    std::lock_guard<std::mutex> lock(texturesMutex);
+    textures.clear();
 }
 
 Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char* fShaderFile, const char* gShaderFile)
@@ -129,23 +173,22 @@ Shader ResourceManager::loadShaderFromFile(const char* vShaderFile, const char*
 }
 
 Texture2D ResourceManager::loadTextureFromFile(const char* file) {
-    // Load info
-    int width, height, nrChannels;
-    // Load image
-    unsigned char* data;
-    data = stbi_load(file, &width, &height, &nrChannels, STBI_default);
-    if (data == nullptr) {
+    return loadTextureFromImage(decodeImage(file), file);
+}
+
+Texture2D ResourceManager::loadTextureFromImage(const ImageData& image, const char* file) {
+    if (image.pixels == nullptr) {
         std::cout << "Failed to load file " << file << std::endl;
     }
     // Create texture object
     Texture2D texture;
     // Determine format
     GLenum format;
-    if (nrChannels == 4) {
+    if (image.channels == 4) {
         format = GL_RGBA;
-    } else if (nrChannels == 1) {
+    } else if (image.channels == 1) {
         format = GL_RED;
-    } else if (nrChannels == 2) {
+    } else if (image.channels == 2) {
         format = GL_RG;
     } else {
         format = GL_RGB;
@@ -153,9 +196,7 @@ Texture2D ResourceManager::loadTextureFromFile(const char* file) {
     texture.internalFormat = format;
     texture.imageFormat = format;
     // Now generate texture
-    texture.generate(width, height, data);
-    // And finally free image data
-    stbi_image_free(data);
+    texture.generate(image.width, image.height, image.pixels.get());
     return texture;
 }
 
@@ -166,7 +207,8 @@ Texture2D ResourceManager::loadTextureFromColor(const glm::vec4 color) {
     data[2] = (unsigned char)(color.z * 255.0f);
     data[3] = (unsigned char)(color.a * 255.0f);
     Texture2D texture;
-    texture.internalFormat = GL_RGBA;
+    // Opaque colors are stored without alpha, so what is drawn with them needs no blending
+    texture.internalFormat = color.a >= 1.0f ? GL_RGB : GL_RGBA;
     texture.imageFormat = GL_RGBA;
     texture.generate(1, 1, data);
     return texture;
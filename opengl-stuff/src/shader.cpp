@@ -1,10 +1,13 @@
 #include "shader.h"
 
+#include "gl_state.h"
+
+#include <algorithm>
 #include <iostream>
 
 Shader& Shader::use()
 {
-    glUseProgram(this->ID);
+    GLState::useProgram(this->ID);
     return *this;
 }
 
@@ -37,6 +40,7 @@ void Shader::compile(const char* vertexSource, const char* fragmentSource, const
         glAttachShader(this->ID, gShader);
     glLinkProgram(this->ID);
     checkCompileErrors(this->ID, "PROGRAM");
+    loadUniformLocations();
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(sVertex);
     glDeleteShader(sFragment);
@@ -46,57 +50,125 @@ void Shader::compile(const char* vertexSource, const char* fragmentSource, const
 
 void Shader::setFloat(const char* name, float value, bool useShader)
 {
-    if (useShader)
-        this->use();
-    glUniform1f(glGetUniformLocation(this->ID, name), value);
+    this->setFloat(this->getUniformLocation(name), value, useShader);
 }
 void Shader::setInteger(const char* name, int value, bool useShader)
 {
-    if (useShader)
-        this->use();
-    glUniform1i(glGetUniformLocation(this->ID, name), value);
+    this->setInteger(this->getUniformLocation(name), value, useShader);
 }
 void Shader::setVector2f(const char* name, float x, float y, bool useShader)
 {
-    if (useShader)
-        this->use();
-    glUniform2f(glGetUniformLocation(this->ID, name), x, y);
+    this->setVector2f(this->getUniformLocation(name), glm::vec2(x, y), useShader);
 }
 void Shader::setVector2f(const char* name, const glm::vec2& value, bool useShader)
+{
+    this->setVector2f(this->getUniformLocation(name), value, useShader);
+}
+void Shader::setVector3f(const char* name, float x, float y, float z, bool useShader)
+{
+    this->setVector3f(this->getUniformLocation(name), glm::vec3(x, y, z), useShader);
+}
+void Shader::setVector3f(const char* name, const glm::vec3& value, bool useShader)
+{
+    this->setVector3f(this->getUniformLocation(name), value, useShader);
+}
+void Shader::setVector4f(const char* name, float x, float y, float z, float w, bool useShader)
+{
+    this->setVector4f(this->getUniformLocation(name), glm::vec4(x, y, z, w), useShader);
+}
+void Shader::setVector4f(const char* name, const glm::vec4& value, bool useShader)
+{
+    this->setVector4f(this->getUniformLocation(name), value, useShader);
+}
+void Shader::setMatrix4(const char* name, const glm::mat4& matrix, bool useShader)
+{
+    this->setMatrix4(this->getUniformLocation(name), matrix, useShader);
+}
+
+void Shader::bindUniformBlock(const char* blockName, GLuint binding)
+{
+    GLuint blockIndex = glGetUniformBlockIndex(this->ID, blockName);
+    if (blockIndex != GL_INVALID_INDEX)
+        glUniformBlockBinding(this->ID, blockIndex, binding);
+}
+
+GLint Shader::getUniformLocation(const char* name) const
+{
+    if (this->uniformLocations == nullptr)
+        return -1;
+    auto locationIt = this->uniformLocations->find(name);
+    return locationIt != this->uniformLocations->end() ? locationIt->second : -1;
+}
+
+void Shader::setFloat(GLint location, float value, bool useShader)
 {
     if (useShader)
         this->use();
-    glUniform2f(glGetUniformLocation(this->ID, name), value.x, value.y);
+    glUniform1f(location, value);
 }
-void Shader::setVector3f(const char* name, float x, float y, float z, bool useShader)
+void Shader::setInteger(GLint location, int value, bool useShader)
 {
     if (useShader)
         this->use();
-    glUniform3f(glGetUniformLocation(this->ID, name), x, y, z);
+    glUniform1i(location, value);
 }
-void Shader::setVector3f(const char* name, const glm::vec3& value, bool useShader)
+void Shader::setVector2f(GLint location, const glm::vec2& value, bool useShader)
 {
     if (useShader)
         this->use();
-    glUniform3f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z);
+    glUniform2f(location, value.x, value.y);
 }
-void Shader::setVector4f(const char* name, float x, float y, float z, float w, bool useShader)
+void Shader::setVector3f(GLint location, const glm::vec3& value, bool useShader)
 {
     if (useShader)
         this->use();
-    glUniform4f(glGetUniformLocation(this->ID, name), x, y, z, w);
+    glUniform3f(location, value.x, value.y, value.z);
 }
-void Shader::setVector4f(const char* name, const glm::vec4& value, bool useShader)
+void Shader::setVector4f(GLint location, const glm::vec4& value, bool useShader)
 {
     if (useShader)
         this->use();
-    glUniform4f(glGetUniformLocation(this->ID, name), value.x, value.y, value.z, value.w);
+    glUniform4f(location, value.x, value.y, value.z, value.w);
 }
-void Shader::setMatrix4(const char* name, const glm::mat4& matrix, bool useShader)
+void Shader::setMatrix4(GLint location, const glm::mat4& matrix, bool useShader)
 {
     if (useShader)
         this->use();
-    glUniformMatrix4fv(glGetUniformLocation(this->ID, name), 1, false, glm::value_ptr(matrix));
+    glUniformMatrix4fv(location, 1, false, glm::value_ptr(matrix));
+}
+
+void Shader::loadUniformLocations()
+{
+    auto locations = std::make_shared<std::unordered_map<std::string, GLint>>();
+    GLint uniformCount = 0, maxNameLength = 0;
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+    glGetProgramiv(this->ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+    std::string name(std::max(maxNameLength, 1), '\0');
+    for (GLint i = 0; i < uniformCount; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type;
+        glGetActiveUniform(this->ID, i, static_cast<GLsizei>(name.size()), &length, &size, &type, &name[0]);
+        std::string uniformName = name.substr(0, length);
+        GLint location = glGetUniformLocation(this->ID, uniformName.c_str());
+        // uniforms of the default block only, block members have no location
+        if (location < 0)
+            continue;
+        (*locations)[uniformName] = location;
+        // arrays are listed once as "name[0]": make them reachable as "name" and by element
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+        {
+            std::string arrayName = uniformName.substr(0, uniformName.size() - 3);
+            (*locations)[arrayName] = location;
+            for (GLint element = 1; element < size; element++)
+            {
+                std::string elementName = arrayName + "[" + std::to_string(element) + "]";
+                (*locations)[elementName] = glGetUniformLocation(this->ID, elementName.c_str());
+            }
+        }
+    }
+    this->uniformLocations = locations;
 }
 
 
@@ -0,0 +1,155 @@
+#include "stream_buffer.h"
+
+#include <cstring>
+
+namespace {
+
+// Frames the GPU may lag behind the CPU, each one keeps its own region of the persistent ring
+const size_t FRAME_REGIONS = 3;
+const size_t INITIAL_REGION_SIZE = 64 * 1024;
+// How long a single wait for a region's fence lasts before it is retried, in nanoseconds
+const GLuint64 FENCE_TIMEOUT = 1000000;
+
+size_t alignUp(size_t offset, size_t alignment) {
+    return alignment > 1 ? (offset + alignment - 1) / alignment * alignment : offset;
+}
+
+}
+
+// Instantiate static variables
+GLuint          StreamBuffer::buffer = 0;
+unsigned char*  StreamBuffer::mapped = nullptr;
+bool            StreamBuffer::persistent = false;
+size_t          StreamBuffer::regionSize = 0;
+size_t          StreamBuffer::region = 0;
+bool            StreamBuffer::regionAcquired = false;
+size_t          StreamBuffer::head = 0;
+GLsync          StreamBuffer::fences[FRAME_REGIONS] = {};
+size_t          StreamBuffer::frameBytes = 0;
+size_t          StreamBuffer::lastFrameBytes = 0;
+GpuMemory::ResourceId StreamBuffer::memoryId = GpuMemory::NONE;
+
+size_t StreamBuffer::upload(const void* data, size_t size, size_t alignment) {
+    if (buffer == 0) {
+        create(INITIAL_REGION_SIZE);
+    }
+    if (!regionAcquired) {
+        acquireRegion();
+    }
+    size_t offset = alignUp(head, alignment);
+    if (offset + size > regionSize) {
+        // The draws already issued this frame keep reading the old buffer, GL deletes it after them
+        size_t grownSize = regionSize * 2;
+        while (grownSize < size) {
+            grownSize *= 2;
+        }
+        create(grownSize);
+        regionAcquired = true;
+        offset = 0;
+    }
+    head = offset + size;
+    frameBytes += size;
+
+    if (persistent) {
+        size_t ringOffset = region * regionSize + offset;
+        std::memcpy(mapped + ringOffset, data, size);
+        return ringOffset;
+    }
+    // Orphaned storage is only written once per frame and never overlaps, so no sync is needed
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    void* target = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (target != nullptr) {
+        std::memcpy(target, data, size);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return offset;
+}
+
+GLuint StreamBuffer::getBuffer() {
+    return buffer;
+}
+
+void StreamBuffer::endFrame() {
+    if (regionAcquired && persistent) {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        region = (region + 1) % FRAME_REGIONS;
+    }
+    regionAcquired = false;
+    head = 0;
+    lastFrameBytes = frameBytes;
+    frameBytes = 0;
+}
+
+size_t StreamBuffer::getFrameBytes() {
+    return lastFrameBytes;
+}
+
+size_t StreamBuffer::getCapacity() {
+    if (buffer == 0) {
+        return 0;
+    }
+    return persistent ? regionSize * FRAME_REGIONS : regionSize;
+}
+
+bool StreamBuffer::isPersistent() {
+    return persistent;
+}
+
+void StreamBuffer::release() {
+    for (GLsync& fence : fences) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    // Deleting a mapped buffer unmaps it
+    glDeleteBuffers(1, &buffer);
+    GpuMemory::untrack(memoryId);
+    buffer = 0;
+    mapped = nullptr;
+    regionAcquired = false;
+    head = 0;
+}
+
+void StreamBuffer::create(size_t regionSize) {
+    release();
+    StreamBuffer::regionSize = regionSize;
+    persistent = GLAD_GL_VERSION_4_4 && glBufferStorage != nullptr;
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, regionSize * FRAME_REGIONS, nullptr, flags);
+        mapped = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, regionSize * FRAME_REGIONS, flags));
+        persistent = mapped != nullptr;
+    }
+    if (!persistent) {
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    // Orphaned storage the GPU still reads is the driver's until it is freed, only the live buffer is counted
+    memoryId = GpuMemory::track(GpuMemoryCategory_Streaming, "stream ring", persistent ? "persistent" : "orphaned", getCapacity());
+}
+
+void StreamBuffer::acquireRegion() {
+    regionAcquired = true;
+    if (!persistent) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return;
+    }
+    GLsync& fence = fences[region];
+    if (fence == nullptr) {
+        return;
+    }
+    // Only stalls when the GPU is FRAME_REGIONS frames behind
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(fence, 0, FENCE_TIMEOUT);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
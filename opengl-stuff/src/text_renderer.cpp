@@ -6,6 +6,9 @@
 
 #include "text_renderer.h"
 #include "resource_manager.h"
+#include "gl_state.h"
+#include "gpu_memory.h"
+#include "stream_buffer.h"
 
 
 TextRenderer::TextRenderer(unsigned int width, unsigned int height, Font font) {
@@ -17,25 +20,42 @@ TextRenderer::TextRenderer(unsigned int width, unsigned int height, Font font) {
     this->shader = ResourceManager::loadShader("assets/shaders/text_2d.vs", "assets/shaders/text_2d.fs", nullptr, "text");
     this->shader.setMatrix4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f), true);
     this->shader.setInteger("text", 0);
-    // configure VAO/VBO for texture quads
+    // configure VAO for texture quads, the vertices are streamed (see renderText)
     glGenVertexArrays(1, &this->VAO);
-    glGenBuffers(1, &this->VBO);
-    glBindVertexArray(this->VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    GLState::bindVertexArray(this->VAO);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLState::bindVertexArray(0);
 
     // Load font characters
     load(font.source, font.size);
 }
 
+TextRenderer::~TextRenderer() {
+    release();
+}
+
+void TextRenderer::release() {
+    releaseGlyphs();
+    if (this->VAO != 0) {
+        GLState::forgetVertexArray(this->VAO);
+        glDeleteVertexArrays(1, &this->VAO);
+        this->VAO = 0;
+    }
+}
+
+void TextRenderer::releaseGlyphs() {
+    for (const auto& character : this->characters) {
+        GLState::forgetTexture(character.second.textureId);
+        glDeleteTextures(1, &character.second.textureId);
+    }
+    this->characters.clear();
+    GpuMemory::untrack(this->glyphMemoryId);
+}
+
 void TextRenderer::load(std::string font, unsigned int fontSize)
 {
-    // first clear the previously loaded Characters
-    this->characters.clear();
+    // first delete the previously loaded Characters
+    releaseGlyphs();
     // then initialize and load the FreeType library
     FT_Library ft;
     if (FT_Init_FreeType(&ft)) // all functions return a value different than 0 whenever an error occurred
@@ -48,6 +68,7 @@ void TextRenderer::load(std::string font, unsigned int fontSize)
     FT_Set_Pixel_Sizes(face, 0, fontSize);
     // disable byte-alignment restriction
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    size_t glyphBytes = 0;
     // then for the first 128 ASCII characters, pre-load/compile their characters and store them
     for (GLubyte c = 0; c < 128; c++) // lol see what I did there 
     {
@@ -60,7 +81,7 @@ void TextRenderer::load(std::string font, unsigned int fontSize)
         // generate texture
         unsigned int texture;
         glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
+        GLState::bindTexture(texture);
 
         // set texture options
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -89,8 +110,11 @@ void TextRenderer::load(std::string font, unsigned int fontSize)
             face->glyph->advance.x
         };
         characters.insert(std::pair<char, Character>(c, character));
+        glyphBytes += GpuMemory::getTextureBytes(GL_RED, face->glyph->bitmap.width, face->glyph->bitmap.rows, false);
     }
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(0);
+    // the glyph textures live until the font is reloaded or the renderer released
+    this->glyphMemoryId = GpuMemory::track(GpuMemoryCategory_Textures, "font " + font, GpuMemory::getFormatName(GL_RED), glyphBytes);
     // destroy FreeType once we're finished
     FT_Done_Face(face);
     FT_Done_FreeType(ft);
@@ -101,18 +125,10 @@ void TextRenderer::renderText(std::string text, float x, float y) {
     this->shader.use();
     this->shader.setVector4f("textColor", color);
 
-    // Bind VAO
-    glBindVertexArray(this->VAO);
-    glActiveTexture(GL_TEXTURE0);
-
-    // Config blending
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
     x = getPositionX(x, text, scale);
 
-    // iterate through all characters
+    // build the quads of all characters first, they are uploaded at once
+    vertices.clear();
     std::string::const_iterator c;
     for (c = text.begin(); c != text.end(); c++)
     {
@@ -123,29 +139,41 @@ void TextRenderer::renderText(std::string text, float x, float y) {
 
         float w = ch.size.x * scale;
         float h = ch.size.y * scale;
-        // update VBO for each character
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 0.0f },
-
-            { xpos,     ypos + h,   0.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 0.0f }
-        };
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.textureId);
-        // update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // be sure to use glBufferSubData and not glBufferData
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        vertices.push_back(glm::vec4(xpos,     ypos + h,   0.0f, 1.0f));
+        vertices.push_back(glm::vec4(xpos + w, ypos,       1.0f, 0.0f));
+        vertices.push_back(glm::vec4(xpos,     ypos,       0.0f, 0.0f));
+
+        vertices.push_back(glm::vec4(xpos,     ypos + h,   0.0f, 1.0f));
+        vertices.push_back(glm::vec4(xpos + w, ypos + h,   1.0f, 1.0f));
+        vertices.push_back(glm::vec4(xpos + w, ypos,       1.0f, 0.0f));
         // now advance cursors for next glyph
         x += (ch.advance >> 6) * scale; // bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
     }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (vertices.empty())
+        return;
+    // aligned to a whole vertex, so the offset can be given as the first vertex of the draws
+    size_t offset = StreamBuffer::upload(vertices.data(), vertices.size() * sizeof(glm::vec4), sizeof(glm::vec4));
+    GLint firstVertex = static_cast<GLint>(offset / sizeof(glm::vec4));
+
+    // Bind VAO, pointed at the stream buffer which changes when it grows
+    GLState::bindVertexArray(this->VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, StreamBuffer::getBuffer());
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    GLState::activeTexture(0);
+
+    // Config blending
+    GLState::setDepthTest(true);
+    GLState::setBlend(true);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // render each glyph texture over its quad
+    for (c = text.begin(); c != text.end(); c++)
+    {
+        GLState::bindTexture(characters[*c].textureId);
+        glDrawArrays(GL_TRIANGLES, firstVertex, 6);
+        firstVertex += 6;
+    }
 }
 
 unsigned int TextRenderer::getPositionX(unsigned int posX, std::string text, float scale) {
@@ -1,28 +1,78 @@
 #include "texture.h"
 
+#include "gl_state.h"
+
 Texture2D::Texture2D()
-    : id(0), width(0), height(0), internalFormat(GL_RGB), imageFormat(GL_RGB), wrapS(GL_REPEAT), wrapT(GL_REPEAT), filterMin(GL_LINEAR), filterMax(GL_LINEAR) { }
+    : id(0), width(0), height(0), internalFormat(GL_RGB), imageFormat(GL_RGB), wrapS(GL_REPEAT), wrapT(GL_REPEAT), filterMin(GL_LINEAR), filterMax(GL_LINEAR), memoryId(GpuMemory::NONE) { }
+
+Texture2D::~Texture2D()
+{
+    if (this->id != 0) {
+        GLState::forgetTexture(this->id);
+        glDeleteTextures(1, &this->id);
+    }
+    GpuMemory::untrack(this->memoryId);
+}
+
+Texture2D::Texture2D(Texture2D&& other) noexcept
+    : id(other.id), width(other.width), height(other.height), internalFormat(other.internalFormat), imageFormat(other.imageFormat),
+    wrapS(other.wrapS), wrapT(other.wrapT), filterMin(other.filterMin), filterMax(other.filterMax), memoryId(other.memoryId)
+{
+    other.id = 0;
+    other.memoryId = GpuMemory::NONE;
+}
+
+Texture2D& Texture2D::operator=(Texture2D&& other) noexcept
+{
+    if (this != &other) {
+        if (this->id != 0) {
+            GLState::forgetTexture(this->id);
+            glDeleteTextures(1, &this->id);
+        }
+        GpuMemory::untrack(this->memoryId);
+        this->id = other.id;
+        this->width = other.width;
+        this->height = other.height;
+        this->internalFormat = other.internalFormat;
+        this->imageFormat = other.imageFormat;
+        this->wrapS = other.wrapS;
+        this->wrapT = other.wrapT;
+        this->filterMin = other.filterMin;
+        this->filterMax = other.filterMax;
+        this->memoryId = other.memoryId;
+        other.id = 0;
+        other.memoryId = GpuMemory::NONE;
+    }
+    return *this;
+}
 
 void Texture2D::generate(unsigned int width, unsigned int height, unsigned char* data)
 {
+    if (this->id != 0) {
+        GLState::forgetTexture(this->id);
+        glDeleteTextures(1, &this->id);
+    }
+    GpuMemory::untrack(this->memoryId);
     glGenTextures(1, &this->id);
     this->width = width;
     this->height = height;
     // Create texture
-    glBindTexture(GL_TEXTURE_2D, this->id);
+    GLState::bindTexture(this->id);
     glTexImage2D(GL_TEXTURE_2D, 0, this->internalFormat, width, height, 0, this->imageFormat, GL_UNSIGNED_BYTE, data);
     // Generate mipmap
     glGenerateMipmap(GL_TEXTURE_2D);
+    this->memoryId = GpuMemory::track(GpuMemoryCategory_Textures, "texture", GpuMemory::getFormatName(this->internalFormat),
+        GpuMemory::getTextureBytes(this->internalFormat, width, height, true));
     // Set texture wrap and filter modes
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, this->wrapS);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, this->wrapT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, this->filterMin);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, this->filterMax);
     // Unbind texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture(0);
 }
 
 void Texture2D::bind() const
 {
-    glBindTexture(GL_TEXTURE_2D, this->id);
+    GLState::bindTexture(this->id);
 }
\ No newline at end of file